@@ -0,0 +1,8 @@
+#version 400 core
+
+out vec4 fColor;
+
+void main(void)
+{
+    fColor = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+}
@@ -0,0 +1,10 @@
+#version 400 core
+
+layout(location=0) in vec2 vertex;
+
+uniform float pos;
+
+void main(void)
+{
+    gl_Position = vec4(vertex.x + pos, vertex.y, 0.0f, 1.0f);
+}
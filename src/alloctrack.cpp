@@ -0,0 +1,240 @@
+#include "alloctrack.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+/**
+ * @brief counters of a named thread, written by the thread and read by the
+ *        report
+ */
+struct NamedSlot
+{
+    std::string_view name;
+    std::atomic<bool> used {false};
+    std::atomic<std::uint64_t> allocations {0};
+    std::atomic<std::uint64_t> deallocations {0};
+    std::atomic<std::uint64_t> bytes {0};
+};
+
+constinit thread_local AllocTrack::Counters threadCounters {};
+constinit thread_local NamedSlot* threadSlot {nullptr};
+constinit std::atomic<std::uint64_t> processAllocations {0};
+constinit std::atomic<std::uint64_t> processDeallocations {0};
+constinit std::atomic<std::uint64_t> processBytes {0};
+constinit std::array<NamedSlot, AllocTrack::maxNamedThreads> namedSlots {};
+constinit std::atomic<std::size_t> namedSlotCount {0};
+
+#ifdef VRR_TEST_ALLOC_TRACKING
+void countAllocation(std::size_t size)
+{
+    ++threadCounters.allocations;
+    threadCounters.bytes += size;
+    processAllocations.fetch_add(1, std::memory_order_relaxed);
+    processBytes.fetch_add(size, std::memory_order_relaxed);
+    if (threadSlot != nullptr)
+    {
+        threadSlot->allocations.fetch_add(1, std::memory_order_relaxed);
+        threadSlot->bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+void countDeallocation(void* ptr)
+{
+    if (ptr != nullptr)
+    {
+        ++threadCounters.deallocations;
+        processDeallocations.fetch_add(1, std::memory_order_relaxed);
+        if (threadSlot != nullptr)
+        {
+            threadSlot->deallocations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void* allocate(std::size_t size)
+{
+    countAllocation(size);
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* allocate(std::size_t size, std::align_val_t align)
+{
+    countAllocation(size);
+    const auto alignment = static_cast<std::size_t>(align);
+    // aligned_alloc wants a multiple of the alignment
+    const auto rounded = (std::max<std::size_t>(size, 1) + alignment - 1)
+                       / alignment * alignment;
+    void* ptr = std::aligned_alloc(alignment, rounded);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void deallocate(void* ptr) noexcept
+{
+    countDeallocation(ptr);
+    std::free(ptr);
+}
+#endif
+
+} // namespace
+
+namespace AllocTrack
+{
+
+Counters thisThread()
+{
+    return threadCounters;
+}
+
+Counters process()
+{
+    constexpr auto order = std::memory_order_relaxed;
+    return {.allocations   = processAllocations.load(order),
+            .deallocations = processDeallocations.load(order),
+            .bytes         = processBytes.load(order)};
+}
+
+void nameThread(std::string_view name)
+{
+    const auto index = namedSlotCount.fetch_add(1, std::memory_order_relaxed);
+    if (index >= namedSlots.size())
+    {
+        return;
+    }
+    auto& slot = namedSlots.at(index);
+    slot.name  = name;
+    slot.used.store(true, std::memory_order_release);
+    threadSlot = &slot;
+}
+
+std::vector<ThreadCounters> namedThreads()
+{
+    constexpr auto order = std::memory_order_relaxed;
+    std::vector<ThreadCounters> threads;
+    for (const auto& slot : namedSlots)
+    {
+        if (slot.used.load(std::memory_order_acquire))
+        {
+            threads.push_back(
+                {.name     = slot.name,
+                 .counters = {.allocations   = slot.allocations.load(order),
+                              .deallocations = slot.deallocations.load(order),
+                              .bytes         = slot.bytes.load(order)}});
+        }
+    }
+    return threads;
+}
+
+} // namespace AllocTrack
+
+#ifdef VRR_TEST_ALLOC_TRACKING
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    return allocate(size, align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+    return allocate(size, align);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t& /*tag*/) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& /*tag*/) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void* ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t /*size*/) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t /*align*/) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t /*align*/) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/,
+                     std::align_val_t /*align*/) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t /*size*/,
+                       std::align_val_t /*align*/) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t& /*tag*/) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t& /*tag*/) noexcept
+{
+    deallocate(ptr);
+}
+#endif
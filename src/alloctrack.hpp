@@ -0,0 +1,62 @@
+#ifndef ALLOCTRACK_HPP
+#define ALLOCTRACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * Heap allocation counters fed by the replaced global operator new and
+ * delete. The replacement is only compiled in with the
+ * VRR_TEST_ALLOC_TRACKING build option, otherwise all counters stay zero.
+ */
+namespace AllocTrack
+{
+
+#ifdef VRR_TEST_ALLOC_TRACKING
+inline constexpr bool enabled = true;
+#else
+inline constexpr bool enabled = false;
+#endif
+
+struct Counters
+{
+    std::uint64_t allocations;
+    std::uint64_t deallocations;
+    std::uint64_t bytes; ///< requested by allocations
+};
+
+/**
+ * @brief counters of the calling thread
+ */
+Counters thisThread();
+
+/**
+ * @brief counters summed over all threads
+ */
+Counters process();
+
+/// threads which can be named, later ones only count into @ref process
+inline constexpr std::size_t maxNamedThreads {16};
+
+struct ThreadCounters
+{
+    std::string_view name;
+    Counters counters;
+};
+
+/**
+ * @brief counts allocations of the calling thread under name from now on
+ * @note name must stay valid until the end of the process
+ */
+void nameThread(std::string_view name);
+
+/**
+ * @brief counters of all named threads, including ones which exited
+ */
+std::vector<ThreadCounters> namedThreads();
+
+} // namespace AllocTrack
+
+#endif // ALLOCTRACK_HPP
@@ -0,0 +1,531 @@
+#include "eventlog.hpp"
+#include "histogram.hpp"
+#include "stutter.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <print>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+struct Config
+{
+    double ksAlpha {0.01};       ///< significance level of the KS test
+    double ksMaxD {0.05};        ///< largest tolerated KS distance
+    double maxDelta {0.5};       ///< largest tolerated percentile shift, ms
+    double maxMissedDelta {0.5}; ///< largest tolerated missed rate rise, %
+    double deadline {0.0};       ///< fixed frame deadline, ms, 0 uses pacer
+    double lateTolerance {Stutter::defaultTolerance}; ///< over deadline, ms
+    double confidence {0.95};
+    unsigned resamples {1000};
+    unsigned threads {std::max(1U, std::thread::hardware_concurrency())};
+    std::uint64_t seed {1};
+    bool help {false};
+    std::vector<std::string> paths;
+};
+
+struct Run
+{
+    std::string path;
+    Histogram hist;
+    std::uint64_t judged {0}; ///< frames with a known deadline
+    std::uint64_t missed {0};
+
+    [[nodiscard]] double missedRate() const
+    {
+        return judged == 0 ? 0.0
+                           : 100.0 * static_cast<double>(missed)
+                                 / static_cast<double>(judged);
+    }
+};
+
+constexpr std::array<double, 3> percentiles {0.50, 0.95, 0.99};
+using PercentileValues = std::array<double, percentiles.size()>;
+
+struct Interval
+{
+    double low;
+    double high;
+};
+
+void usage()
+{
+    std::println("usage: vrr-compare [options] BASELINE CANDIDATE...");
+    std::println("  inputs are event logs written by vrr-test --record or text "
+                 "files with one frame time in ms per line");
+    std::println("  --ks-alpha A        KS significance level, default 0.01");
+    std::println("  --ks-max-d D        tolerated KS distance, default 0.05");
+    std::println("  --max-delta MS      tolerated percentile shift, "
+                 "default 0.5");
+    std::println("  --max-missed-delta PCT  tolerated missed-deadline rate "
+                 "rise, default 0.5");
+    std::println("  --deadline MS       frame deadline of text files and "
+                 "version 1 logs, default their recorded pacer interval");
+    std::println("  --late-tolerance MS  tolerance over that deadline, "
+                 "default {}",
+                 Stutter::defaultTolerance);
+    std::println("  --confidence C      bootstrap confidence, default 0.95");
+    std::println("  --resamples N       bootstrap resamples, default 1000");
+    std::println("  --threads N         resampling threads, default all cores");
+    std::println("  --seed N            bootstrap seed, default 1");
+    std::println("  --help              print this help");
+}
+
+template<typename T>
+T parseNumber(std::string_view str)
+{
+    T value {};
+    const auto* end = str.data() + str.size();
+    const auto res  = std::from_chars(str.data(), end, value);
+    if (res.ec != std::errc {} || res.ptr != end)
+    {
+        throw std::runtime_error(std::format("invalid number: {}", str));
+    }
+    return value;
+}
+
+Config parseArgs(std::span<char*> args)
+{
+    Config cfg;
+    for (auto it = args.begin(); it != args.end(); ++it)
+    {
+        const std::string_view arg(*it);
+        if (!arg.starts_with("--"))
+        {
+            cfg.paths.emplace_back(arg);
+            continue;
+        }
+        if (arg == "--help")
+        {
+            cfg.help = true;
+            continue;
+        }
+        if (std::next(it) == args.end())
+        {
+            throw std::runtime_error(std::format("missing value of {}", arg));
+        }
+        const std::string_view value(*++it);
+        if (arg == "--ks-alpha")
+        {
+            cfg.ksAlpha = parseNumber<double>(value);
+        }
+        else if (arg == "--ks-max-d")
+        {
+            cfg.ksMaxD = parseNumber<double>(value);
+        }
+        else if (arg == "--max-delta")
+        {
+            cfg.maxDelta = parseNumber<double>(value);
+        }
+        else if (arg == "--max-missed-delta")
+        {
+            cfg.maxMissedDelta = parseNumber<double>(value);
+        }
+        else if (arg == "--deadline")
+        {
+            cfg.deadline = parseNumber<double>(value);
+        }
+        else if (arg == "--late-tolerance")
+        {
+            cfg.lateTolerance = parseNumber<double>(value);
+        }
+        else if (arg == "--confidence")
+        {
+            cfg.confidence = parseNumber<double>(value);
+        }
+        else if (arg == "--resamples")
+        {
+            cfg.resamples = parseNumber<unsigned>(value);
+        }
+        else if (arg == "--threads")
+        {
+            cfg.threads = std::max(1U, parseNumber<unsigned>(value));
+        }
+        else if (arg == "--seed")
+        {
+            cfg.seed = parseNumber<std::uint64_t>(value);
+        }
+        else
+        {
+            throw std::runtime_error(std::format("unknown option {}", arg));
+        }
+    }
+    if (cfg.confidence <= 0.0 || cfg.confidence >= 1.0)
+    {
+        throw std::runtime_error("confidence must be in range (0, 1)");
+    }
+    return cfg;
+}
+
+std::string_view trim(std::string_view str)
+{
+    constexpr std::string_view space = " \t\r\n";
+    const auto first                 = str.find_first_not_of(space);
+    if (first == std::string_view::npos)
+    {
+        return {};
+    }
+    return str.substr(first, str.find_last_not_of(space) - first + 1);
+}
+
+void judge(const Config& cfg, Run& run, double ms, double deadline)
+{
+    if (deadline <= 0.0)
+    {
+        return;
+    }
+    ++run.judged;
+    if (ms > deadline + cfg.lateTolerance)
+    {
+        ++run.missed;
+    }
+}
+
+void loadEventLog(const Config& cfg, Run& run)
+{
+    EventLog::Reader log(run.path);
+    EventLog::FrameRecord frame {};
+    std::optional<std::uint32_t> previousTarget;
+    while (log.nextFrame(frame, [](const EventLog::KeyRecord&) {}))
+    {
+        // interval stored with a frame was measured at its start, so it
+        // belongs to the previous frame and its pacer target
+        if (frame.cls != EventLog::unknownClass)
+        {
+            // count the frames vrr-test classified, so both tools agree
+            ++run.judged;
+            if (static_cast<Stutter::FrameClass>(frame.cls)
+                != Stutter::FrameClass::OnTime)
+            {
+                ++run.missed;
+            }
+        }
+        if (previousTarget)
+        {
+            const auto ms = frame.interval * 1000.0;
+            run.hist.add(ms);
+            if (frame.cls == EventLog::unknownClass)
+            {
+                judge(cfg, run, ms,
+                      cfg.deadline > 0.0 ? cfg.deadline
+                                         : *previousTarget / 1000.0);
+            }
+        }
+        previousTarget = frame.targetInterval;
+    }
+}
+
+void loadText(const Config& cfg, Run& run)
+{
+    std::ifstream file(run.path);
+    if (!file)
+    {
+        throw std::runtime_error(std::format("cannot open {}", run.path));
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+        const auto str = trim(line);
+        if (str.empty() || str.starts_with('#'))
+        {
+            continue;
+        }
+        const auto ms = parseNumber<double>(str);
+        run.hist.add(ms);
+        judge(cfg, run, ms, cfg.deadline);
+    }
+}
+
+Run load(const Config& cfg, const std::string& path)
+{
+    Run run {.path = path};
+    if (EventLog::isEventLog(path))
+    {
+        loadEventLog(cfg, run);
+    }
+    else
+    {
+        loadText(cfg, run);
+    }
+    if (run.hist.count() == 0)
+    {
+        throw std::runtime_error(std::format("{}: no frames", path));
+    }
+    return run;
+}
+
+/**
+ * @brief asymptotic Kolmogorov distribution, probability of distance at
+ *        least lambda
+ */
+double kolmogorovQ(double lambda)
+{
+    if (lambda < 0.2)
+    {
+        return 1.0;
+    }
+    double sum  = 0.0;
+    double sign = 1.0;
+    for (int k = 1; k <= 100; ++k)
+    {
+        const auto term
+            = sign * 2.0 * std::exp(-2.0 * k * k * lambda * lambda);
+        sum += term;
+        if (std::abs(term) < 1e-12)
+        {
+            break;
+        }
+        sign = -sign;
+    }
+    return std::clamp(sum, 0.0, 1.0);
+}
+
+/**
+ * @brief two sample Kolmogorov-Smirnov test on binned distributions
+ * @return distance and p-value
+ */
+std::pair<double, double> ksTest(const Histogram& a, const Histogram& b)
+{
+    const auto na = static_cast<double>(a.count());
+    const auto nb = static_cast<double>(b.count());
+    double ca     = 0.0;
+    double cb     = 0.0;
+    double d      = 0.0;
+    for (std::size_t bin = 0; bin < Histogram::binCount; ++bin)
+    {
+        ca += static_cast<double>(a.at(bin)) / na;
+        cb += static_cast<double>(b.at(bin)) / nb;
+        d   = std::max(d, std::abs(ca - cb));
+    }
+    const auto ne = std::sqrt(na * nb / (na + nb));
+    return {d, kolmogorovQ((ne + 0.12 + 0.11 / ne) * d)};
+}
+
+/**
+ * @brief non-empty bins of a histogram, the resampling works on these only
+ */
+struct SparseHistogram
+{
+    explicit SparseHistogram(const Histogram& hist) : total(hist.count())
+    {
+        for (std::size_t bin = 0; bin < Histogram::binCount; ++bin)
+        {
+            if (hist.at(bin) != 0)
+            {
+                bins.emplace_back(bin, hist.at(bin));
+            }
+        }
+    }
+
+    std::vector<std::pair<std::size_t, std::uint64_t>> bins;
+    std::uint64_t total;
+};
+
+/**
+ * @brief percentiles of one bootstrap resample
+ *
+ * Drawing total samples with replacement is a multinomial draw over the
+ * bins, done as a chain of binomial draws, so the cost depends on the number
+ * of distinct bins and not on the length of the recording.
+ */
+PercentileValues resample(const SparseHistogram& hist, std::mt19937_64& rng)
+{
+    PercentileValues values {};
+    PercentileValues ranks {};
+    const auto total = static_cast<double>(hist.total);
+    std::ranges::transform(percentiles, ranks.begin(), [total](double p)
+                           { return std::max(1.0, std::ceil(p * total)); });
+
+    std::uint64_t drawsLeft  = hist.total;
+    std::uint64_t weightLeft = hist.total;
+    std::uint64_t cumulative = 0;
+    std::size_t next         = 0;
+    for (const auto& [bin, count] : hist.bins)
+    {
+        std::uint64_t drawn = drawsLeft;
+        if (count < weightLeft)
+        {
+            std::binomial_distribution<std::uint64_t> dist(
+                drawsLeft,
+                static_cast<double>(count) / static_cast<double>(weightLeft));
+            drawn = dist(rng);
+        }
+        drawsLeft  -= drawn;
+        weightLeft -= count;
+        cumulative += drawn;
+        while (next < ranks.size()
+               && static_cast<double>(cumulative) >= ranks.at(next))
+        {
+            values.at(next++) = Histogram::binCenter(bin);
+        }
+        if (next == ranks.size())
+        {
+            break;
+        }
+    }
+    return values;
+}
+
+/**
+ * @brief bootstrap confidence intervals of candidate minus baseline
+ *        percentiles
+ * @note every resample seeds its own generator, so the result does not
+ *       depend on the number of threads
+ */
+std::array<Interval, percentiles.size()>
+bootstrap(const Config& cfg, const Histogram& baseline,
+          const Histogram& candidate)
+{
+    const SparseHistogram base(baseline);
+    const SparseHistogram cand(candidate);
+    std::vector<PercentileValues> deltas(cfg.resamples);
+
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned t = 0; t < cfg.threads; ++t)
+        {
+            workers.emplace_back(
+                [&, t]()
+                {
+                    for (std::size_t r = t; r < deltas.size();
+                         r += cfg.threads)
+                    {
+                        std::seed_seq seq {cfg.seed, std::uint64_t {r}};
+                        std::mt19937_64 rng(seq);
+                        const auto a = resample(base, rng);
+                        const auto b = resample(cand, rng);
+                        for (std::size_t i = 0; i < a.size(); ++i)
+                        {
+                            deltas[r].at(i) = b.at(i) - a.at(i);
+                        }
+                    }
+                });
+        }
+    }
+
+    std::array<Interval, percentiles.size()> intervals {};
+    std::vector<double> column(deltas.size());
+    const auto tail = (1.0 - cfg.confidence) / 2.0;
+    for (std::size_t i = 0; i < percentiles.size(); ++i)
+    {
+        std::ranges::transform(deltas, column.begin(),
+                               [i](const auto& d) { return d.at(i); });
+        std::ranges::sort(column);
+        auto quantile = [&column](double q)
+        {
+            const auto idx = static_cast<std::size_t>(
+                q * static_cast<double>(column.size() - 1));
+            return column[idx];
+        };
+        intervals.at(i) = {quantile(tail), quantile(1.0 - tail)};
+    }
+    return intervals;
+}
+
+/**
+ * @brief prints comparison of candidate against baseline
+ * @return true if candidate passed
+ */
+bool compare(const Config& cfg, const Run& baseline, const Run& candidate)
+{
+    bool pass    = true;
+    auto verdict = [&pass](bool ok)
+    {
+        pass = pass && ok;
+        return ok ? "ok" : "FAIL";
+    };
+
+    std::println("candidate {} ({} frames)", candidate.path,
+                 candidate.hist.count());
+
+    const auto [d, p] = ksTest(baseline.hist, candidate.hist);
+    std::println("  ks: D={:.4f} p={:.4g} {}", d, p,
+                 verdict(p >= cfg.ksAlpha || d <= cfg.ksMaxD));
+
+    if (cfg.resamples != 0)
+    {
+        const auto intervals = bootstrap(cfg, baseline.hist, candidate.hist);
+        for (std::size_t i = 0; i < percentiles.size(); ++i)
+        {
+            const auto pct  = percentiles.at(i);
+            const auto base = baseline.hist.percentile(pct);
+            const auto cand = candidate.hist.percentile(pct);
+            const auto& ci  = intervals.at(i);
+            std::println("  p{:.0f}: {:.2f} -> {:.2f} ms, delta {:+.2f} "
+                         "[{:+.2f}, {:+.2f}] {}",
+                         pct * 100.0, base, cand, cand - base, ci.low, ci.high,
+                         verdict(ci.low <= cfg.maxDelta));
+        }
+    }
+
+    if (baseline.judged != 0 && candidate.judged != 0)
+    {
+        const auto delta = candidate.missedRate() - baseline.missedRate();
+        std::println("  missed: {:.2f}% -> {:.2f}% ({:+.2f} pp) {}",
+                     baseline.missedRate(), candidate.missedRate(), delta,
+                     verdict(delta <= cfg.maxMissedDelta));
+    }
+    else
+    {
+        std::println("  missed: no deadline known, use --deadline");
+    }
+
+    std::println("  verdict: {}", pass ? "PASS" : "FAIL");
+    return pass;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        const auto cfg = parseArgs(std::span<char*>(argv + 1, argc - 1));
+        if (cfg.help)
+        {
+            usage();
+            return 0;
+        }
+        if (cfg.paths.size() < 2)
+        {
+            usage();
+            return 2;
+        }
+
+        const auto baseline = load(cfg, cfg.paths.front());
+        std::println("baseline {} ({} frames)", baseline.path,
+                     baseline.hist.count());
+
+        bool pass = true;
+        for (const auto& path : std::span(cfg.paths).subspan(1))
+        {
+            pass = compare(cfg, baseline, load(cfg, path)) && pass;
+        }
+        std::cout.flush();
+        return pass ? 0 : 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+    }
+
+    return 2;
+}
@@ -0,0 +1,242 @@
+#include "eventlog.hpp"
+#include "misc.hpp"
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <ios>
+#include <source_location>
+#include <stdexcept>
+
+namespace EventLog
+{
+
+namespace
+{
+
+enum class Type : std::uint8_t
+{
+    Frame = 1,
+    Key   = 2,
+    Burst = 3
+};
+
+constexpr std::size_t maxPayload = 255;
+
+/**
+ * @brief packs fields back to back without padding
+ */
+class Payload
+{
+public:
+    template<typename T>
+    Payload& put(const T& value)
+    {
+        std::memcpy(buffer.data() + size, &value, sizeof(T));
+        size += sizeof(T);
+        return *this;
+    }
+
+    template<typename T>
+    Payload& get(T& value)
+    {
+        if (pos + sizeof(T) > size)
+        {
+            throw std::runtime_error(std::format(
+                "{:short}: record too short", std::source_location::current()));
+        }
+        std::memcpy(&value, buffer.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return *this;
+    }
+
+    std::array<char, maxPayload> buffer {};
+    std::size_t size = 0;
+    std::size_t pos  = 0;
+};
+
+void writeRecord(std::ofstream& file, const std::string& path, Type type,
+                 const Payload& payload)
+{
+    const std::array<char, 2> head {static_cast<char>(type),
+                                    static_cast<char>(payload.size)};
+    file.write(head.data(), head.size());
+    file.write(payload.buffer.data(),
+               static_cast<std::streamsize>(payload.size));
+    if (!file)
+    {
+        throw std::runtime_error(std::format("{:short}: cannot write {}",
+                                             std::source_location::current(),
+                                             path));
+    }
+}
+
+} // namespace
+
+Writer::Writer(const std::string& path)
+    : file(path, std::ios::binary | std::ios::trunc), path(path)
+{
+    if (!file)
+    {
+        throw std::runtime_error(std::format("{:short}: cannot create {}",
+                                             std::source_location::current(),
+                                             path));
+    }
+    Payload header;
+    header.put(magic).put(version).put(std::uint16_t {0});
+    file.write(header.buffer.data(), static_cast<std::streamsize>(header.size));
+}
+
+void Writer::close()
+{
+    file.close();
+    if (!file)
+    {
+        throw std::runtime_error(std::format("{:short}: cannot write {}",
+                                             std::source_location::current(),
+                                             path));
+    }
+}
+
+void Writer::write(const FrameRecord& rec)
+{
+    Payload payload;
+    payload.put(rec.frame)
+        .put(rec.clock)
+        .put(rec.interval)
+        .put(rec.targetInterval)
+        .put(rec.pos)
+        .put(rec.cls);
+    writeRecord(file, path, Type::Frame, payload);
+}
+
+void Writer::write(const KeyRecord& rec)
+{
+    Payload payload;
+    payload.put(rec.frame).put(rec.key).put(rec.action).put(rec.mods);
+    writeRecord(file, path, Type::Key, payload);
+}
+
+void Writer::write(const BurstRecord& rec)
+{
+    Payload payload;
+    payload.put(rec.firstFrame)
+        .put(rec.frames)
+        .put(rec.dropped)
+        .put(rec.start)
+        .put(rec.duration)
+        .put(rec.cause);
+    writeRecord(file, path, Type::Burst, payload);
+}
+
+Reader::Reader(const std::string& path)
+    : file(path, std::ios::binary), path(path)
+{
+    if (!file)
+    {
+        throw std::runtime_error(std::format(
+            "{:short}: cannot open {}", std::source_location::current(), path));
+    }
+    Payload header;
+    header.size = sizeof(magic) + sizeof(version) + sizeof(std::uint16_t);
+    file.read(header.buffer.data(), static_cast<std::streamsize>(header.size));
+    std::uint32_t fileMagic    = 0;
+    std::uint16_t fileReserved = 0;
+    if (file)
+    {
+        header.get(fileMagic).get(fileVersion).get(fileReserved);
+    }
+    if (fileMagic != magic)
+    {
+        throw std::runtime_error(std::format("{:short}: {} is not an event log",
+                                             std::source_location::current(),
+                                             path));
+    }
+    if (fileVersion > version)
+    {
+        throw std::runtime_error(
+            std::format("{:short}: {}: unsupported event log version {}",
+                        std::source_location::current(), path, fileVersion));
+    }
+}
+
+bool Reader::next(Record& rec)
+{
+    while (true)
+    {
+        std::array<char, 2> head {};
+        if (!file.read(head.data(), head.size()))
+        {
+            if (file.gcount() != 0)
+            {
+                throw std::runtime_error(
+                    std::format("{:short}: {}: truncated record",
+                                std::source_location::current(), path));
+            }
+            return false;
+        }
+
+        Payload payload;
+        payload.size = static_cast<std::uint8_t>(head[1]);
+        if (!file.read(payload.buffer.data(),
+                       static_cast<std::streamsize>(payload.size)))
+        {
+            throw std::runtime_error(
+                std::format("{:short}: {}: truncated record",
+                            std::source_location::current(), path));
+        }
+
+        switch (static_cast<Type>(head[0]))
+        {
+            case Type::Frame:
+            {
+                FrameRecord frame {};
+                payload.get(frame.frame)
+                    .get(frame.clock)
+                    .get(frame.interval)
+                    .get(frame.targetInterval)
+                    .get(frame.pos);
+                frame.cls = unknownClass;
+                if (fileVersion >= 2)
+                {
+                    payload.get(frame.cls);
+                }
+                rec = frame;
+                return true;
+            }
+            case Type::Key:
+            {
+                KeyRecord key {};
+                payload.get(key.frame)
+                    .get(key.key)
+                    .get(key.action)
+                    .get(key.mods);
+                rec = key;
+                return true;
+            }
+            case Type::Burst:
+            {
+                BurstRecord burst {};
+                payload.get(burst.firstFrame)
+                    .get(burst.frames)
+                    .get(burst.dropped)
+                    .get(burst.start)
+                    .get(burst.duration)
+                    .get(burst.cause);
+                rec = burst;
+                return true;
+            }
+            default: break; // unknown record type, skip
+        }
+    }
+}
+
+bool isEventLog(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::uint32_t fileMagic = 0;
+    file.read(reinterpret_cast<char*>(&fileMagic), sizeof(fileMagic));
+    return file && fileMagic == magic;
+}
+
+} // namespace EventLog
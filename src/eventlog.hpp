@@ -0,0 +1,138 @@
+#ifndef EVENTLOG_HPP
+#define EVENTLOG_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <variant>
+
+/**
+ * Compact binary log of everything that makes a run nondeterministic.
+ *
+ * The file starts with a header (magic, version) followed by records. Each
+ * record is a one byte type, a one byte payload size and the payload in host
+ * byte order. Readers skip record types they do not know, so new types can be
+ * added without breaking older logs.
+ */
+namespace EventLog
+{
+
+inline constexpr std::uint32_t magic   = 0x4C525256; // "VRRL"
+inline constexpr std::uint16_t version = 2;
+
+/// frame class of frames from version 1 logs, which did not record it
+inline constexpr std::uint8_t unknownClass = 0xFF;
+
+/**
+ * @brief state of one rendered frame
+ */
+struct FrameRecord
+{
+    std::uint64_t frame;          ///< frame index
+    double clock;                 ///< clock sample driving the bar, seconds
+    double interval;              ///< measured time since last frame, seconds
+    std::uint32_t targetInterval; ///< pacer decision, microseconds
+    float pos;                    ///< bar position
+    std::uint8_t cls;             ///< Stutter::FrameClass or unknownClass
+};
+
+/**
+ * @brief keyboard event delivered while polling events after @ref frame
+ */
+struct KeyRecord
+{
+    std::uint64_t frame;
+    std::int32_t key;
+    std::int32_t action;
+    std::int32_t mods;
+};
+
+/**
+ * @brief stutter burst, written when the burst ends
+ */
+struct BurstRecord
+{
+    std::uint64_t firstFrame;
+    std::uint64_t frames;
+    std::uint64_t dropped;
+    double start;       ///< deadline of the first frame since start, seconds
+    double duration;    ///< seconds
+    std::uint8_t cause; ///< Stutter::Cause
+};
+
+using Record = std::variant<FrameRecord, KeyRecord, BurstRecord>;
+
+/**
+ * @brief writes a log, failing writes throw std::runtime_error
+ */
+class Writer
+{
+public:
+    explicit Writer(const std::string& path);
+
+    void write(const FrameRecord& rec);
+    void write(const KeyRecord& rec);
+    void write(const BurstRecord& rec);
+
+    /**
+     * @brief flushes and closes the log
+     * @throw std::runtime_error if any buffered record could not be written
+     */
+    void close();
+
+private:
+    std::ofstream file;
+    std::string path;
+};
+
+class Reader
+{
+public:
+    explicit Reader(const std::string& path);
+
+    /**
+     * @brief reads next known record
+     * @return false at end of file
+     * @throw std::runtime_error on truncated or malformed log
+     */
+    bool next(Record& rec);
+
+    /**
+     * @brief reads records until next frame
+     * @param onKey called for every key record in between
+     * @return false at end of file
+     */
+    template<typename F>
+    bool nextFrame(FrameRecord& frame, F&& onKey)
+    {
+        Record rec;
+        while (next(rec))
+        {
+            if (const auto* f = std::get_if<FrameRecord>(&rec))
+            {
+                frame = *f;
+                return true;
+            }
+            if (const auto* k = std::get_if<KeyRecord>(&rec))
+            {
+                onKey(*k);
+            }
+        }
+        return false;
+    }
+
+private:
+    std::ifstream file;
+    std::string path;
+    std::uint16_t fileVersion {0};
+};
+
+/**
+ * @brief checks whether file at path starts with event log magic
+ */
+bool isEventLog(const std::string& path);
+
+} // namespace EventLog
+
+#endif // EVENTLOG_HPP
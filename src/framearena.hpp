@@ -0,0 +1,33 @@
+#ifndef FRAMEARENA_HPP
+#define FRAMEARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+/**
+ * @brief scratch memory which lives for one frame
+ *
+ * Allocations bump a pointer in a buffer reserved up front and are all
+ * released at once by @ref reset between frames. Running out of space throws
+ * std::bad_alloc instead of falling back to the heap.
+ */
+class FrameArena
+{
+public:
+    explicit FrameArena(std::size_t capacity)
+        : buffer(std::make_unique<std::byte[]>(capacity)),
+          arena(buffer.get(), capacity, std::pmr::null_memory_resource())
+    {
+    }
+
+    [[nodiscard]] std::pmr::memory_resource* resource() { return &arena; }
+
+    void reset() { arena.release(); }
+
+private:
+    std::unique_ptr<std::byte[]> buffer;
+    std::pmr::monotonic_buffer_resource arena;
+};
+
+#endif // FRAMEARENA_HPP
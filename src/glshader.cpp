@@ -2,6 +2,7 @@
 #include "glmisc.hpp"
 #include "misc.hpp"
 #include <format>
+#include <initializer_list>
 #include <source_location>
 #include <stdexcept>
 #include <string_view>
@@ -14,6 +15,16 @@ GLShader::GLShader(std::string_view name)
 
 GLShader::~GLShader()
 {
+    // stages are left over when compiling or linking failed, attached ones
+    // are freed together with the program
+    for (const auto shaderID : {vertexShaderID, geometryShaderID,
+                                fragmentShaderID})
+    {
+        if (shaderID != 0)
+        {
+            glDeleteShader(shaderID);
+        }
+    }
     glDeleteProgram(programID);
 }
 
@@ -46,7 +57,7 @@ void GLShader::addUniform(const std::string& uniform)
     uniforms.insert({uniform, loc});
 }
 
-void GLShader::compile() const
+void GLShader::compile()
 {
     glLinkProgram(programID);
     try
@@ -60,20 +71,15 @@ void GLShader::compile() const
                         std::source_location::current(), err.what()));
     }
 
-    if (glIsShader(vertexShaderID))
-    {
-        glDetachShader(programID, vertexShaderID);
-        glDeleteShader(vertexShaderID);
-    }
-    if (glIsShader(geometryShaderID))
-    {
-        glDetachShader(programID, geometryShaderID);
-        glDeleteShader(geometryShaderID);
-    }
-    if (glIsShader(fragmentShaderID))
+    for (auto* shaderID : {&vertexShaderID, &geometryShaderID,
+                           &fragmentShaderID})
     {
-        glDetachShader(programID, fragmentShaderID);
-        glDeleteShader(fragmentShaderID);
+        if (*shaderID != 0)
+        {
+            glDetachShader(programID, *shaderID);
+            glDeleteShader(*shaderID);
+            *shaderID = 0;
+        }
     }
 
     GLMisc::checkGLerror();
@@ -84,7 +90,7 @@ GLuint GLShader::getProgramID() const
     return programID;
 }
 
-GLint GLShader::getUniformLocation(const std::string& uniform)
+GLint GLShader::getUniformLocation(std::string_view uniform) const
 {
     auto it = uniforms.find(uniform);
     if (it == uniforms.end())
@@ -1,6 +1,7 @@
 #ifndef GLSHADER_H
 #define GLSHADER_H
 
+#include <functional>
 #include <GL/glew.h>
 #include <map>
 #include <string>
@@ -19,9 +20,9 @@ public:
     void addVertexStage(const std::string& str);
     void addFragmentStage(const std::string& file);
     void addUniform(const std::string& uniform);
-    void compile() const;
+    void compile();
     [[nodiscard]] GLuint getProgramID() const;
-    GLint getUniformLocation(const std::string& uniform);
+    [[nodiscard]] GLint getUniformLocation(std::string_view uniform) const;
     [[nodiscard]] std::string getName() const { return name; }
 
 private:
@@ -34,7 +35,7 @@ private:
     GLuint geometryShaderID = 0;
     GLuint fragmentShaderID = 0;
     std::string name;
-    std::map<std::string, GLint> uniforms;
+    std::map<std::string, GLint, std::less<>> uniforms;
 };
 
 #endif // GLSHADER_H
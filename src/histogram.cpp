@@ -0,0 +1,52 @@
+#include "histogram.hpp"
+#include <algorithm>
+#include <cmath>
+
+Histogram::Histogram() : bins(binCount, 0) {}
+
+void Histogram::add(double ms)
+{
+    ++bins[binOf(ms)];
+    ++total;
+}
+
+void Histogram::clear()
+{
+    std::ranges::fill(bins, 0);
+    total = 0;
+}
+
+double Histogram::percentile(double p) const
+{
+    if (total == 0)
+    {
+        return 0.0;
+    }
+    const auto rank = std::max<std::uint64_t>(
+        1,
+        static_cast<std::uint64_t>(std::ceil(p * static_cast<double>(total))));
+    std::uint64_t cumulative = 0;
+    for (std::size_t bin = 0; bin < bins.size(); ++bin)
+    {
+        cumulative += bins[bin];
+        if (cumulative >= rank)
+        {
+            return binCenter(bin);
+        }
+    }
+    return binCenter(bins.size() - 1);
+}
+
+double Histogram::binCenter(std::size_t bin)
+{
+    return (static_cast<double>(bin) + 0.5) * binWidth;
+}
+
+std::size_t Histogram::binOf(double ms)
+{
+    if (!(ms > 0.0))
+    {
+        return 0;
+    }
+    return std::min(static_cast<std::size_t>(ms / binWidth), binCount - 1);
+}
@@ -0,0 +1,50 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief fixed resolution histogram of frame times
+ *
+ * Memory does not depend on the number of samples, so arbitrarily long
+ * recordings can be streamed into it. Samples above @ref range land in the
+ * last bin.
+ */
+class Histogram
+{
+public:
+    static constexpr double binWidth {0.01}; ///< ms
+    static constexpr double range {250.0};   ///< ms
+    static constexpr std::size_t binCount {
+        static_cast<std::size_t>(range / binWidth) + 1};
+
+    Histogram();
+
+    void add(double ms);
+
+    /**
+     * @brief removes all samples, keeps the bins allocated
+     */
+    void clear();
+
+    [[nodiscard]] std::uint64_t count() const { return total; }
+    [[nodiscard]] std::uint64_t at(std::size_t bin) const { return bins[bin]; }
+
+    /**
+     * @brief nearest-rank percentile
+     * @param p fraction in range (0, 1]
+     * @return center of the bin holding the percentile, ms
+     */
+    [[nodiscard]] double percentile(double p) const;
+
+    static double binCenter(std::size_t bin);
+    static std::size_t binOf(double ms);
+
+private:
+    std::vector<std::uint64_t> bins;
+    std::uint64_t total {0};
+};
+
+#endif // HISTOGRAM_HPP
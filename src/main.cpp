@@ -1,12 +1,184 @@
+#include "alloctrack.hpp"
+#include "rendertarget.hpp"
 #include "window.hpp"
-#include <iostream>
+#include <charconv>
 #include <exception>
+#include <format>
+#include <glm/glm.hpp>
+#include <iostream>
+#include <iterator>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+
+void usage()
+{
+    std::println("usage: vrr-test [--metrics SEGMENT] [--no-metrics] "
+                 "[--record FILE] [--replay FILE [--diff FILE]] "
+                 "[--report FILE] [--late-tolerance MS] [--shader-dir DIR] "
+                 "[--warmup N] [--assert-no-alloc] [--render-scale S] "
+                 "[--render-size WxH] [--msaa N]");
+    std::println("  --metrics SEGMENT  shared memory segment for live metrics, "
+                 "default {}",
+                 Metrics::defaultSegmentName);
+    std::println("  --no-metrics       do not export live metrics");
+    std::println("  --record FILE      record input and timing into FILE");
+    std::println("  --replay FILE      re-drive a run recorded into FILE");
+    std::println("  --diff FILE        write per-frame replay differences "
+                 "as csv");
+    std::println("  --report FILE      also write the final report into FILE");
+    std::println("  --late-tolerance MS  frames finishing later after their "
+                 "deadline are late, default {}",
+                 Stutter::defaultTolerance);
+    std::println("  --shader-dir DIR   load strip.vert and strip.frag from DIR "
+                 "and reload them on change");
+    std::println("  --warmup N         frames discarded before timing starts, "
+                 "default 60");
+    std::println("  --assert-no-alloc  fail when a frame allocates from the "
+                 "heap, needs a VRR_TEST_ALLOC_TRACKING build");
+    std::println("  --render-scale S   render at S times the base size, "
+                 "{} to {}, default 1",
+                 RenderTarget::minScale, RenderTarget::maxScale);
+    std::println("  --render-size WxH  base size of the render target, "
+                 "default the window size");
+    std::println("  --msaa N           MSAA samples of the render target, "
+                 "0 disables, default 4");
+}
 
-int main()
+template<typename T>
+T parseNumber(std::string_view str)
 {
+    T value {};
+    const auto* end = str.data() + str.size();
+    const auto res  = std::from_chars(str.data(), end, value);
+    if (res.ec != std::errc {} || res.ptr != end)
+    {
+        throw std::runtime_error(std::format("invalid number: {}", str));
+    }
+    return value;
+}
+
+glm::ivec2 parseSize(std::string_view str)
+{
+    const auto sep = str.find('x');
+    if (sep == std::string_view::npos)
+    {
+        throw std::runtime_error(std::format("invalid size: {}", str));
+    }
+    const glm::ivec2 size {parseNumber<int>(str.substr(0, sep)),
+                           parseNumber<int>(str.substr(sep + 1))};
+    if (size.x <= 0 || size.y <= 0)
+    {
+        throw std::runtime_error(std::format("invalid size: {}", str));
+    }
+    return size;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    AllocTrack::nameThread("main");
     try
     {
-        Window window;
+        Window::Options options;
+
+        const std::span<char*> args(argv + 1, argc - 1);
+        for (auto it = args.begin(); it != args.end(); ++it)
+        {
+            const std::string_view arg(*it);
+            if (arg == "--no-metrics")
+            {
+                options.metricsName.clear();
+            }
+            else if (arg == "--assert-no-alloc")
+            {
+                options.assertNoAlloc = true;
+            }
+            else if (arg == "--metrics" && std::next(it) != args.end())
+            {
+                options.metricsName = *++it;
+            }
+            else if (arg == "--record" && std::next(it) != args.end())
+            {
+                options.recordPath = *++it;
+            }
+            else if (arg == "--replay" && std::next(it) != args.end())
+            {
+                options.replayPath = *++it;
+            }
+            else if (arg == "--diff" && std::next(it) != args.end())
+            {
+                options.diffPath = *++it;
+            }
+            else if (arg == "--report" && std::next(it) != args.end())
+            {
+                options.reportPath = *++it;
+            }
+            else if (arg == "--late-tolerance" && std::next(it) != args.end())
+            {
+                options.lateTolerance = parseNumber<double>(*++it);
+            }
+            else if (arg == "--shader-dir" && std::next(it) != args.end())
+            {
+                options.shaderDir = *++it;
+            }
+            else if (arg == "--warmup" && std::next(it) != args.end())
+            {
+                options.warmupFrames = parseNumber<unsigned>(*++it);
+            }
+            else if (arg == "--render-scale" && std::next(it) != args.end())
+            {
+                options.renderScale = parseNumber<float>(*++it);
+            }
+            else if (arg == "--render-size" && std::next(it) != args.end())
+            {
+                options.renderSize = parseSize(*++it);
+            }
+            else if (arg == "--msaa" && std::next(it) != args.end())
+            {
+                options.msaaSamples = parseNumber<int>(*++it);
+            }
+            else
+            {
+                usage();
+                return arg == "--help" ? 0 : 1;
+            }
+        }
+
+        if (!options.diffPath.empty() && options.replayPath.empty())
+        {
+            throw std::runtime_error("--diff requires --replay");
+        }
+        if (!options.recordPath.empty()
+            && options.recordPath == options.replayPath)
+        {
+            throw std::runtime_error("cannot record into the replayed log");
+        }
+
+        if (options.renderScale < RenderTarget::minScale
+            || options.renderScale > RenderTarget::maxScale)
+        {
+            throw std::runtime_error(
+                std::format("--render-scale must be between {} and {}",
+                            RenderTarget::minScale, RenderTarget::maxScale));
+        }
+        if (options.msaaSamples < 0)
+        {
+            throw std::runtime_error("--msaa must not be negative");
+        }
+
+        if (options.assertNoAlloc && !AllocTrack::enabled)
+        {
+            throw std::runtime_error("--assert-no-alloc needs a build with "
+                                     "VRR_TEST_ALLOC_TRACKING");
+        }
+
+        Window window(options);
         window.init();
         window.exec();
         return 0;
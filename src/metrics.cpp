@@ -0,0 +1,235 @@
+#include "metrics.hpp"
+#include "misc.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <signal.h>
+#include <source_location>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace Metrics
+{
+
+namespace
+{
+
+std::atomic_ref<std::uint64_t> wordRef(const std::uint64_t& word)
+{
+    // atomic_ref cannot view const objects, loads never write through it
+    return std::atomic_ref<std::uint64_t>(const_cast<std::uint64_t&>(word));
+}
+
+/**
+ * @brief checks whether the segment was left behind by a publisher which
+ *        died without unlinking it
+ */
+bool isStale(const std::string& name)
+{
+    try
+    {
+        const Reader reader(name);
+        return !reader.isLive();
+    }
+    catch (const std::runtime_error&)
+    {
+        // not a segment of this version, leave it alone
+    }
+    return false;
+}
+
+} // namespace
+
+Publisher::Publisher(std::string_view name) : name(name)
+{
+    constexpr int flags = O_CREAT | O_EXCL | O_RDWR;
+    int fd              = shm_open(this->name.c_str(), flags, 0644);
+    int err             = errno;
+    if (fd == -1 && err == EEXIST && isStale(this->name))
+    {
+        shm_unlink(this->name.c_str());
+        fd  = shm_open(this->name.c_str(), flags, 0644);
+        err = errno;
+    }
+    if (fd == -1)
+    {
+        if (err == EEXIST)
+        {
+            throw std::runtime_error(
+                std::format("{:short}: {} is used by another vrr-test, "
+                            "choose another segment with --metrics",
+                            std::source_location::current(), this->name));
+        }
+        throw std::runtime_error(std::format("{:short}: shm_open {}: {}",
+                                             std::source_location::current(),
+                                             this->name, std::strerror(err)));
+    }
+    if (ftruncate(fd, sizeof(Segment)) == -1)
+    {
+        err = errno;
+        close(fd);
+        shm_unlink(this->name.c_str());
+        throw std::runtime_error(std::format("{:short}: ftruncate {}: {}",
+                                             std::source_location::current(),
+                                             this->name, std::strerror(err)));
+    }
+    void* ptr = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+    err = errno;
+    close(fd);
+    if (ptr == MAP_FAILED)
+    {
+        shm_unlink(this->name.c_str());
+        throw std::runtime_error(std::format("{:short}: mmap {}: {}",
+                                             std::source_location::current(),
+                                             this->name, std::strerror(err)));
+    }
+
+    segment = static_cast<Segment*>(ptr);
+    wordRef(segment->sequence).store(0, std::memory_order_relaxed);
+    segment->payload = {};
+    segment->version = segmentVersion;
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->magic = segmentMagic;
+
+    // the owner pid lets a later publisher recognise a stale segment
+    Snapshot initial {};
+    initial.pid = getpid();
+    publish(initial);
+}
+
+Publisher::~Publisher()
+{
+    if (segment != nullptr)
+    {
+        munmap(segment, sizeof(Segment));
+        shm_unlink(name.c_str());
+    }
+}
+
+void Publisher::publish(const Snapshot& snapshot)
+{
+    std::array<std::uint64_t, snapshotWords> words {};
+    std::memcpy(words.data(), &snapshot, sizeof(Snapshot));
+
+    auto seq       = wordRef(segment->sequence);
+    const auto odd = seq.load(std::memory_order_relaxed) + 1;
+    seq.store(odd, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < snapshotWords; ++i)
+    {
+        wordRef(segment->payload[i]).store(words[i], std::memory_order_relaxed);
+    }
+    seq.store(odd + 1, std::memory_order_release);
+}
+
+Reader::Reader(std::string_view name)
+{
+    const std::string segName(name);
+    fd = shm_open(segName.c_str(), O_RDONLY, 0);
+    if (fd == -1)
+    {
+        throw std::runtime_error(std::format("{:short}: shm_open {}: {}",
+                                             std::source_location::current(),
+                                             segName, std::strerror(errno)));
+    }
+    // a publisher creates the segment before sizing it, mapping it in
+    // between would fault on the first access
+    struct stat info {};
+    if (fstat(fd, &info) == -1
+        || info.st_size < static_cast<off_t>(sizeof(Segment)))
+    {
+        close(fd);
+        throw std::runtime_error(
+            std::format("{:short}: {}: not a vrr-test metrics segment",
+                        std::source_location::current(), segName));
+    }
+    void* ptr = mmap(nullptr, sizeof(Segment), PROT_READ, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED)
+    {
+        const int err = errno;
+        close(fd);
+        throw std::runtime_error(std::format("{:short}: mmap {}: {}",
+                                             std::source_location::current(),
+                                             segName, std::strerror(err)));
+    }
+    segment = static_cast<const Segment*>(ptr);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (segment->magic != segmentMagic || segment->version != segmentVersion)
+    {
+        munmap(const_cast<Segment*>(segment), sizeof(Segment));
+        close(fd);
+        throw std::runtime_error(
+            std::format("{:short}: {}: not a vrr-test metrics segment",
+                        std::source_location::current(), segName));
+    }
+}
+
+Reader::~Reader()
+{
+    munmap(const_cast<Segment*>(segment), sizeof(Segment));
+    close(fd);
+}
+
+bool Reader::tryRead(Snapshot& snapshot) const
+{
+    std::array<std::uint64_t, snapshotWords> words {};
+
+    auto seq          = wordRef(segment->sequence);
+    const auto before = seq.load(std::memory_order_acquire);
+    if ((before & 1U) != 0)
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < snapshotWords; ++i)
+    {
+        words[i] = wordRef(segment->payload[i]).load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const auto after = seq.load(std::memory_order_relaxed);
+    if (before != after)
+    {
+        return false;
+    }
+
+    std::memcpy(&snapshot, words.data(), sizeof(Snapshot));
+    return true;
+}
+
+bool Reader::isLive() const
+{
+    constexpr int readAttempts = 1000;
+
+    // the publisher unlinks the segment when it exits
+    struct stat info {};
+    if (fstat(fd, &info) == -1 || info.st_nlink == 0)
+    {
+        return false;
+    }
+    Snapshot snapshot {};
+    for (int i = 0; i < readAttempts; ++i)
+    {
+        if (tryRead(snapshot))
+        {
+            return snapshot.pid == 0
+                || kill(static_cast<pid_t>(snapshot.pid), 0) == 0
+                || errno != ESRCH;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+Snapshot Reader::read() const
+{
+    Snapshot snapshot {};
+    while (!tryRead(snapshot)) { std::this_thread::yield(); }
+    return snapshot;
+}
+
+} // namespace Metrics
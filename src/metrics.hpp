@@ -0,0 +1,119 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Metrics
+{
+
+inline constexpr std::string_view defaultSegmentName = "/vrr-test-metrics";
+inline constexpr std::uint32_t segmentMagic          = 0x56525254; // "VRRT"
+inline constexpr std::uint32_t segmentVersion        = 2;
+
+/**
+ * @brief live state of the render loop as seen by external readers
+ * @note every field is 8 bytes wide so the snapshot can be copied word by
+ *       word with atomic accesses, keep it that way when adding fields
+ */
+struct Snapshot
+{
+    std::int64_t pid;              ///< process id of the writer
+    std::uint64_t frameCount;      ///< frames rendered since start
+    double targetRate;             ///< fps limit of the pacer
+    double achievedRate;           ///< fps measured over the last second
+    double p50FrameTime;           ///< median frame time in ms
+    double p95FrameTime;           ///< 95th percentile frame time in ms
+    double p99FrameTime;           ///< 99th percentile frame time in ms
+    std::uint64_t missedDeadlines; ///< late and dropped frames
+    std::int64_t swapInterval;     ///< 0 immediate, 1 vsync
+    std::uint64_t droppedFrames;   ///< frames late by a whole interval
+    std::uint64_t stutterBursts;   ///< ended bursts of late frames
+    double lastBurstDuration;      ///< ms
+    std::int64_t lastBurstCause;   ///< Stutter::Cause of the last burst
+};
+
+static_assert(sizeof(Snapshot) % sizeof(std::uint64_t) == 0);
+static_assert(std::atomic_ref<std::uint64_t>::is_always_lock_free);
+
+inline constexpr std::size_t snapshotWords
+    = sizeof(Snapshot) / sizeof(std::uint64_t);
+
+/**
+ * @brief layout of the shared memory segment
+ *
+ * The snapshot is guarded by a seqlock: the writer makes @ref sequence odd,
+ * stores the payload and makes it even again. Readers retry until they see
+ * the same even sequence before and after copying the payload, so the writer
+ * never waits for them.
+ */
+struct Segment
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t sequence;
+    std::array<std::uint64_t, snapshotWords> payload;
+};
+
+/**
+ * @brief creates the segment and publishes snapshots into it
+ * @note creating fails while another live publisher owns the segment, a
+ *       segment left by a dead one is replaced. The segment is unlinked when
+ *       the publisher is destroyed.
+ */
+class Publisher
+{
+public:
+    explicit Publisher(std::string_view name = defaultSegmentName);
+    ~Publisher();
+    Publisher(const Publisher& o)            = delete;
+    Publisher(Publisher&& o)                 = delete;
+    Publisher* operator=(const Publisher& o) = delete;
+    Publisher* operator=(Publisher&& o)      = delete;
+
+    void publish(const Snapshot& snapshot);
+
+private:
+    std::string name;
+    Segment* segment = nullptr;
+};
+
+/**
+ * @brief read-only view of a segment created by @ref Publisher
+ */
+class Reader
+{
+public:
+    explicit Reader(std::string_view name = defaultSegmentName);
+    ~Reader();
+    Reader(const Reader& o)            = delete;
+    Reader(Reader&& o)                 = delete;
+    Reader* operator=(const Reader& o) = delete;
+    Reader* operator=(Reader&& o)      = delete;
+
+    /**
+     * @brief single seqlock read attempt
+     * @return false if the writer was in the middle of an update
+     */
+    bool tryRead(Snapshot& snapshot) const;
+    [[nodiscard]] Snapshot read() const;
+
+    /**
+     * @brief checks that the segment is still linked and its publisher runs
+     * @note a restarted publisher creates a new segment, which needs a new
+     *       reader
+     */
+    [[nodiscard]] bool isLive() const;
+
+private:
+    int fd {-1};
+    const Segment* segment = nullptr;
+};
+
+} // namespace Metrics
+
+#endif // METRICS_HPP
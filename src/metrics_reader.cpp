@@ -0,0 +1,113 @@
+#include "metrics.hpp"
+#include "stutter.hpp"
+#include <charconv>
+#include <chrono>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <iterator>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace
+{
+
+void usage()
+{
+    std::println(
+        "usage: vrr-metrics [--name SEGMENT] [--interval MS] [--once]");
+    std::println("  --name SEGMENT  shared memory segment, default {}",
+                 Metrics::defaultSegmentName);
+    std::println("  --interval MS   poll period, default 1000");
+    std::println("  --once          print a single sample and exit");
+}
+
+bool parseUnsigned(std::string_view str, unsigned& value)
+{
+    const auto* end = str.data() + str.size();
+    const auto res  = std::from_chars(str.data(), end, value);
+    return res.ec == std::errc {} && res.ptr == end;
+}
+
+void print(const Metrics::Snapshot& s)
+{
+    const auto cause = static_cast<Stutter::Cause>(s.lastBurstCause);
+    std::println("pid={} frames={} target_fps={:.2f} fps={:.2f} "
+                 "p50_ms={:.3f} p95_ms={:.3f} p99_ms={:.3f} missed={} "
+                 "dropped={} bursts={} last_burst_ms={:.3f} "
+                 "last_burst_cause=\"{}\" swap={}",
+                 s.pid, s.frameCount, s.targetRate, s.achievedRate,
+                 s.p50FrameTime, s.p95FrameTime, s.p99FrameTime,
+                 s.missedDeadlines, s.droppedFrames, s.stutterBursts,
+                 s.lastBurstDuration,
+                 Stutter::toString(cause),
+                 s.swapInterval == 0 ? "immediate" : "vsync");
+    std::cout.flush();
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        std::string name(Metrics::defaultSegmentName);
+        unsigned interval = 1000;
+        bool once         = false;
+
+        const std::span<char*> args(argv + 1, argc - 1);
+        for (auto it = args.begin(); it != args.end(); ++it)
+        {
+            const std::string_view arg(*it);
+            if (arg == "--once")
+            {
+                once = true;
+            }
+            else if ((arg == "--name" || arg == "--interval")
+                     && std::next(it) != args.end())
+            {
+                const std::string_view value(*++it);
+                if (arg == "--name")
+                {
+                    name = value;
+                }
+                else if (!parseUnsigned(value, interval) || interval == 0)
+                {
+                    throw std::runtime_error(
+                        std::format("invalid interval: {}", value));
+                }
+            }
+            else
+            {
+                usage();
+                return arg == "--help" ? 0 : 1;
+            }
+        }
+
+        const Metrics::Reader reader(name);
+        while (true)
+        {
+            if (!reader.isLive())
+            {
+                throw std::runtime_error(
+                    std::format("{}: publisher exited", name));
+            }
+            print(reader.read());
+            if (once)
+            {
+                return 0;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+    }
+
+    return 1;
+}
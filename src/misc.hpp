@@ -2,12 +2,13 @@
 #define MISC_HPP
 
 #include <format>
-#include <GL/glew.h>
 #include <iterator>
 #include <source_location>
 #include <string_view>
 
 #if 0
+#include <GL/glew.h>
+
 template<>
 struct std::formatter<GLubyte const*> : public std::formatter<char const*>
 {
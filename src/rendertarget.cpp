@@ -0,0 +1,117 @@
+#include "rendertarget.hpp"
+#include "glmisc.hpp"
+#include "misc.hpp"
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <source_location>
+#include <stdexcept>
+
+RenderTarget::RenderTarget(int samples)
+{
+    GLint maxSamples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    this->samples = std::clamp(samples, 0, maxSamples);
+    glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+}
+
+RenderTarget::~RenderTarget()
+{
+    release();
+}
+
+void RenderTarget::resize(glm::ivec2 base, float scale)
+{
+    auto scaled = [this, scale](int length)
+    {
+        return std::clamp(
+            static_cast<int>(std::lround(static_cast<float>(length) * scale)),
+            1, maxSize);
+    };
+
+    const glm::ivec2 newSize {scaled(base.x), scaled(base.y)};
+    if (newSize.x == size.x && newSize.y == size.y)
+    {
+        return;
+    }
+    release();
+    size = newSize;
+    allocate();
+}
+
+void RenderTarget::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, samples > 0 ? msaaFBO : resolveFBO);
+    glViewport(0, 0, size.x, size.y);
+}
+
+void RenderTarget::present(glm::ivec2 displaySize) const
+{
+    if (samples > 0)
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, msaaFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFBO);
+        glBlitFramebuffer(0, 0, size.x, size.y, 0, 0, size.x, size.y,
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+
+    const bool sameSize = size.x == displaySize.x && size.y == displaySize.y;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, resolveFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, size.x, size.y, 0, 0, displaySize.x, displaySize.y,
+                      GL_COLOR_BUFFER_BIT, sameSize ? GL_NEAREST : GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLMisc::checkGLerror();
+}
+
+void RenderTarget::allocate()
+{
+    glGenRenderbuffers(1, &resolveColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, resolveColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+    glGenFramebuffers(1, &resolveFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, resolveColor);
+    checkComplete();
+
+    if (samples > 0)
+    {
+        glGenRenderbuffers(1, &msaaColor);
+        glBindRenderbuffer(GL_RENDERBUFFER, msaaColor);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8,
+                                         size.x, size.y);
+        glGenFramebuffers(1, &msaaFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, msaaFBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                  GL_RENDERBUFFER, msaaColor);
+        checkComplete();
+    }
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLMisc::checkGLerror();
+}
+
+void RenderTarget::release()
+{
+    glDeleteFramebuffers(1, &msaaFBO);
+    glDeleteRenderbuffers(1, &msaaColor);
+    glDeleteFramebuffers(1, &resolveFBO);
+    glDeleteRenderbuffers(1, &resolveColor);
+    msaaFBO      = 0;
+    msaaColor    = 0;
+    resolveFBO   = 0;
+    resolveColor = 0;
+}
+
+void RenderTarget::checkComplete()
+{
+    const auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        throw std::runtime_error(
+            std::format("{:short}: incomplete framebuffer: {:#x}",
+                        std::source_location::current(), status));
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef RENDERTARGET_HPP
+#define RENDERTARGET_HPP
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/**
+ * @brief offscreen framebuffer the scene is rendered into
+ *
+ * The target has its own resolution, so the fill cost does not depend on the
+ * window size. With multisampling the scene is drawn into a multisampled
+ * framebuffer and resolved into a single sampled one of the same size, which
+ * is then scaled into the default framebuffer.
+ */
+class RenderTarget
+{
+public:
+    static constexpr float minScale {0.25F};
+    static constexpr float maxScale {4.0F};
+
+    /**
+     * @param samples MSAA samples, 0 disables multisampling
+     */
+    explicit RenderTarget(int samples);
+    ~RenderTarget();
+    RenderTarget(const RenderTarget& o)            = delete;
+    RenderTarget(RenderTarget&& o)                 = delete;
+    RenderTarget* operator=(const RenderTarget& o) = delete;
+    RenderTarget* operator=(RenderTarget&& o)      = delete;
+
+    /**
+     * @brief sizes the target to base scaled by scale
+     * @note reallocates only if the resulting size changed
+     */
+    void resize(glm::ivec2 base, float scale);
+
+    /**
+     * @brief binds the target for drawing and sets the viewport to it
+     */
+    void bind() const;
+
+    /**
+     * @brief resolves the target and blits it into the default framebuffer
+     */
+    void present(glm::ivec2 displaySize) const;
+
+    [[nodiscard]] glm::ivec2 getSize() const { return size; }
+    [[nodiscard]] int getSamples() const { return samples; }
+
+private:
+    void allocate();
+    void release();
+    static void checkComplete();
+
+    int samples;
+    GLint maxSize {0}; ///< largest renderbuffer dimension
+    glm::ivec2 size {0, 0};
+    GLuint msaaFBO {0};
+    GLuint msaaColor {0};
+    GLuint resolveFBO {0};
+    GLuint resolveColor {0};
+};
+
+#endif // RENDERTARGET_HPP
@@ -0,0 +1,148 @@
+#include "shaderreloader.hpp"
+#include "alloctrack.hpp"
+#include "misc.hpp"
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <poll.h>
+#include <print>
+#include <source_location>
+#include <stdexcept>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <utility>
+
+namespace
+{
+
+/// editors write files in several steps, wait for them to settle
+constexpr auto settleTime = std::chrono::milliseconds(50);
+constexpr int pollTimeout = 100; // ms, bounds the shutdown latency
+/// saved in place or renamed over the old file
+constexpr std::uint32_t watchMask = IN_CLOSE_WRITE | IN_MOVED_TO;
+
+/**
+ * @brief reads all pending events
+ * @return true if there were any
+ */
+bool drainEvents(int fd)
+{
+    alignas(inotify_event) std::array<char, 4096> buffer {};
+    bool any = false;
+    while (read(fd, buffer.data(), buffer.size()) > 0) { any = true; }
+    return any;
+}
+
+} // namespace
+
+ShaderReloader::ShaderReloader(GLFWwindow* share, const std::string& dir,
+                               Builder build)
+    : build(std::move(build))
+{
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd == -1
+        || inotify_add_watch(inotifyFd, dir.c_str(), watchMask) == -1)
+    {
+        const int err = errno;
+        if (inotifyFd != -1)
+        {
+            close(inotifyFd);
+        }
+        throw std::runtime_error(std::format("{:short}: cannot watch {}: {}",
+                                             std::source_location::current(),
+                                             dir, std::strerror(err)));
+    }
+
+    // inherits the context hints of the main window
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    context = glfwCreateWindow(1, 1, "vrr-test shaders", nullptr, share);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (context == nullptr)
+    {
+        close(inotifyFd);
+        throw std::runtime_error(
+            std::format("{:short}: cannot create shared context",
+                        std::source_location::current()));
+    }
+
+    worker = std::jthread([this](const std::stop_token& stop) { run(stop); });
+}
+
+ShaderReloader::~ShaderReloader()
+{
+    worker.request_stop();
+    worker.join();
+    glfwDestroyWindow(context);
+    close(inotifyFd);
+}
+
+std::unique_ptr<GLShader> ShaderReloader::takeReady()
+{
+    if (!hasReady.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+    const std::scoped_lock lock(mutex);
+    hasReady.store(false, std::memory_order_relaxed);
+    return std::move(ready);
+}
+
+void ShaderReloader::run(const std::stop_token& stop)
+{
+    AllocTrack::nameThread("shader reload");
+    glfwMakeContextCurrent(context);
+
+    pollfd pfd {.fd = inotifyFd, .events = POLLIN, .revents = 0};
+    while (!stop.stop_requested())
+    {
+        if (poll(&pfd, 1, pollTimeout) <= 0 || !drainEvents(inotifyFd))
+        {
+            continue;
+        }
+        do
+        {
+            std::this_thread::sleep_for(settleTime);
+        } while (drainEvents(inotifyFd));
+        rebuild();
+    }
+
+    // a program which was never taken must be released on this context
+    {
+        const std::scoped_lock lock(mutex);
+        ready.reset();
+        hasReady.store(false, std::memory_order_relaxed);
+    }
+    glfwMakeContextCurrent(nullptr);
+}
+
+void ShaderReloader::rebuild()
+{
+    std::unique_ptr<GLShader> shader;
+    try
+    {
+        shader = build();
+        // the main context must see a fully linked program
+        glFinish();
+    }
+    catch (const std::runtime_error& err)
+    {
+        std::println("shader reload failed, keeping previous program:\n{}",
+                     err.what());
+        std::cout.flush();
+        return;
+    }
+
+    std::println("shader {} reloaded", shader->getName());
+    std::cout.flush();
+
+    std::unique_ptr<GLShader> stale;
+    {
+        const std::scoped_lock lock(mutex);
+        stale = std::exchange(ready, std::move(shader));
+        hasReady.store(true, std::memory_order_release);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef SHADERRELOADER_HPP
+#define SHADERRELOADER_HPP
+
+#include "glshader.h"
+#include <atomic>
+#include <functional>
+#include <GLFW/glfw3.h>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+
+/**
+ * @brief rebuilds a shader program in the background when its sources change
+ *
+ * A worker thread watches the source directory with inotify. On a change it
+ * runs the builder on a hidden context which shares objects with the main
+ * one, so compiling and linking never stall the render loop. A program is
+ * handed over only once it linked successfully; on errors the old program
+ * stays in use.
+ */
+class ShaderReloader
+{
+public:
+    using Builder = std::function<std::unique_ptr<GLShader>()>;
+
+    /**
+     * @param share context to share objects with, must be current on the
+     *        calling thread
+     * @param dir directory to watch
+     * @param build creates the program from the current sources
+     */
+    ShaderReloader(GLFWwindow* share, const std::string& dir, Builder build);
+    ~ShaderReloader();
+    ShaderReloader(const ShaderReloader& o)            = delete;
+    ShaderReloader(ShaderReloader&& o)                 = delete;
+    ShaderReloader* operator=(const ShaderReloader& o) = delete;
+    ShaderReloader* operator=(ShaderReloader&& o)      = delete;
+
+    /**
+     * @brief program linked since the last call
+     * @return nullptr if there is none, does not block
+     */
+    std::unique_ptr<GLShader> takeReady();
+
+private:
+    void run(const std::stop_token& stop);
+    void rebuild();
+
+    GLFWwindow* context = nullptr;
+    int inotifyFd       = -1;
+    Builder build;
+
+    std::mutex mutex;
+    std::unique_ptr<GLShader> ready;
+    std::atomic<bool> hasReady {false};
+
+    std::jthread worker;
+};
+
+#endif // SHADERRELOADER_HPP
@@ -1,16 +1,23 @@
 #include "strip.hpp"
 #include "glmisc.hpp"
+#include <filesystem>
+#include <fstream>
 #include <GL/glew.h>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <utility>
 
-void Strip::draw(float pos)
+Strip::Strip(std::string shaderDir) : shaderDir(std::move(shaderDir)) {}
+
+void Strip::init()
 {
-    if (shader == nullptr)
-    {
-        initShader();
-    }
+    setShader(buildShader());
+    initBuffers();
+}
 
+void Strip::draw(float pos)
+{
     glUseProgram(shader->getProgramID());
     glUniform1f(posUniformLocation, pos);
     glBindVertexArray(VAOID);
@@ -18,18 +25,24 @@ void Strip::draw(float pos)
     GLMisc::checkGLerror();
 }
 
-void Strip::initShader()
+std::unique_ptr<GLShader> Strip::buildShader() const
 {
-    shader = std::make_unique<GLShader>("strip");
-    shader->addVertexStage(std::string(vertexShader));
-    shader->addFragmentStage(std::string(fragmentShader));
-    shader->compile();
-    shader->addUniform("pos");
+    auto newShader = std::make_unique<GLShader>("strip");
+    newShader->addVertexStage(loadSource("strip.vert", vertexShader));
+    newShader->addFragmentStage(loadSource("strip.frag", fragmentShader));
+    newShader->compile();
+    newShader->addUniform("pos");
+    return newShader;
+}
 
+void Strip::setShader(std::unique_ptr<GLShader> newShader)
+{
+    shader             = std::move(newShader);
     posUniformLocation = shader->getUniformLocation("pos");
+}
 
-    glUseProgram(shader->getProgramID());
-
+void Strip::initBuffers()
+{
     glGenVertexArrays(1, &VAOID);
     glBindVertexArray(VAOID);
 
@@ -41,3 +54,20 @@ void Strip::initShader()
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
     GLMisc::checkGLerror();
 }
+
+std::string Strip::loadSource(std::string_view file,
+                              std::string_view fallback) const
+{
+    if (shaderDir.empty())
+    {
+        return std::string(fallback);
+    }
+    const auto path = std::filesystem::path(shaderDir) / file;
+    std::ifstream in(path);
+    if (!in)
+    {
+        return std::string(fallback);
+    }
+    return {std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()};
+}
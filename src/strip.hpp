@@ -6,21 +6,49 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <memory>
+#include <string>
 #include <string_view>
 
 class Strip
 {
 public:
+    /**
+     * @param shaderDir directory with strip.vert and strip.frag, built-in
+     *        sources are used for missing files
+     */
+    explicit Strip(std::string shaderDir = {});
+
+    /**
+     * @brief builds the program and vertex buffers
+     * @note must be called with the context current before the first draw
+     */
+    void init();
+
     void draw(float pos);
 
+    /**
+     * @brief compiles and links the program from current sources
+     * @note only reads immutable state, safe to call from a thread with
+     *       a shared context current
+     */
+    [[nodiscard]] std::unique_ptr<GLShader> buildShader() const;
+
+    /**
+     * @brief replaces the program, takes effect with the next draw
+     */
+    void setShader(std::unique_ptr<GLShader> newShader);
+
 private:
-    void initShader();
+    void initBuffers();
+    [[nodiscard]] std::string loadSource(std::string_view file,
+                                         std::string_view fallback) const;
 
-    GLuint VBOID;
-    GLuint VAOID;
-    GLint posUniformLocation;
+    GLuint VBOID {0};
+    GLuint VAOID {0};
+    GLint posUniformLocation {-1};
 
     std::unique_ptr<GLShader> shader;
+    std::string shaderDir;
 
     static constexpr float width {0.1F};
     static constexpr std::array<glm::vec2, 4> vertices {
@@ -0,0 +1,172 @@
+#include "stutter.hpp"
+#include <algorithm>
+#include <format>
+#include <iterator>
+#include <ranges>
+
+namespace Stutter
+{
+
+namespace
+{
+
+double toMs(Duration d)
+{
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+Cause dominantCause(const std::array<Duration, causeCount>& lateness)
+{
+    const auto it = std::ranges::max_element(lateness);
+    return *it > Duration::zero()
+             ? static_cast<Cause>(std::distance(lateness.begin(), it))
+             : Cause::None;
+}
+
+} // namespace
+
+std::string_view toString(FrameClass cls)
+{
+    switch (cls)
+    {
+        case FrameClass::OnTime: return "on-time";
+        case FrameClass::Late: return "late";
+        case FrameClass::Dropped: return "dropped";
+    }
+    return "unknown";
+}
+
+std::string_view toString(Cause cause)
+{
+    switch (cause)
+    {
+        case Cause::None: return "none";
+        case Cause::PacerOversleep: return "pacer oversleep";
+        case Cause::DrawSubmit: return "draw submit";
+        case Cause::SwapBlock: return "swap block";
+        case Cause::EventPolling: return "event polling";
+    }
+    return "unknown";
+}
+
+Classifier::Classifier(Duration tolerance) : tolerance(tolerance)
+{
+    finished.reserve(maxKeptBursts);
+}
+
+FrameResult Classifier::frame(std::uint64_t index, const FrameTiming& timing)
+{
+    if (!origin)
+    {
+        origin = timing.start;
+    }
+
+    const auto zero = Duration::zero();
+
+    // lateness splits into the phases, each counted from the later of its
+    // own start and the deadline. The deadline lies after the previous swap,
+    // so a frame can only start late because polling events ran past it.
+    std::array<Duration, causeCount> phases {};
+    phases[static_cast<std::size_t>(Cause::EventPolling)]
+        += std::min(std::max(zero, timing.start - timing.deadline),
+                    previousPoll);
+    phases[static_cast<std::size_t>(Cause::DrawSubmit)] += std::max(
+        zero, timing.drawEnd - std::max(timing.start, timing.deadline));
+    phases[static_cast<std::size_t>(Cause::PacerOversleep)] += std::max(
+        zero, timing.wake - std::max(timing.drawEnd, timing.deadline));
+    phases[static_cast<std::size_t>(Cause::SwapBlock)] += std::max(
+        zero, timing.swapEnd - std::max(timing.wake, timing.deadline));
+    previousPoll = timing.pollEnd - timing.swapEnd;
+
+    FrameResult result {.cls        = FrameClass::OnTime,
+                        .cause      = Cause::None,
+                        .lateness   = timing.swapEnd - timing.deadline,
+                        .endedBurst = std::nullopt};
+    if (result.lateness > tolerance)
+    {
+        result.cls   = result.lateness >= timing.interval ? FrameClass::Dropped
+                                                          : FrameClass::Late;
+        result.cause = dominantCause(phases);
+    }
+    ++classCounts.at(static_cast<std::size_t>(result.cls));
+
+    if (result.cls == FrameClass::OnTime)
+    {
+        result.endedBurst = finish();
+        return result;
+    }
+
+    for (std::size_t i = 0; i < causeCount; ++i)
+    {
+        causeLateness.at(i)   += phases.at(i);
+        runningLateness.at(i) += phases.at(i);
+    }
+    if (!running)
+    {
+        running = Burst {.firstFrame = index,
+                         .frames     = 0,
+                         .dropped    = 0,
+                         .start      = timing.deadline - *origin,
+                         .duration   = zero,
+                         .cause      = Cause::None};
+    }
+    ++running->frames;
+    if (result.cls == FrameClass::Dropped)
+    {
+        ++running->dropped;
+    }
+    running->duration = timing.swapEnd - *origin - running->start;
+    return result;
+}
+
+std::optional<Burst> Classifier::finish()
+{
+    if (!running)
+    {
+        return std::nullopt;
+    }
+    auto burst  = *running;
+    burst.cause = dominantCause(runningLateness);
+    running.reset();
+    runningLateness = {};
+    ++burstCount;
+    if (finished.size() < maxKeptBursts)
+    {
+        finished.push_back(burst);
+    }
+    return burst;
+}
+
+void Classifier::report(std::ostream& out) const
+{
+    constexpr std::size_t longestShown = 10;
+
+    out << std::format("frames: {} on-time, {} late, {} dropped\n",
+                       count(FrameClass::OnTime), count(FrameClass::Late),
+                       count(FrameClass::Dropped));
+    for (std::size_t i = 1; i < causeCount; ++i)
+    {
+        out << std::format("lateness from {}: {:.3f} ms\n",
+                           toString(static_cast<Cause>(i)),
+                           toMs(causeLateness.at(i)));
+    }
+
+    out << std::format("stutter bursts: {}\n", burstCount);
+    std::vector<const Burst*> longest;
+    longest.reserve(finished.size());
+    std::ranges::transform(finished, std::back_inserter(longest),
+                           [](const Burst& b) { return &b; });
+    std::ranges::sort(longest, std::ranges::greater {},
+                      [](const Burst* b) { return b->duration; });
+    for (const auto* b : longest | std::views::take(longestShown))
+    {
+        out << std::format("  frame {} at {:.3f} s: {} frames, {} dropped, "
+                           "{:.3f} ms, {}\n",
+                           b->firstFrame,
+                           std::chrono::duration<double>(b->start).count(),
+                           b->frames, b->dropped, toMs(b->duration),
+                           toString(b->cause));
+    }
+}
+
+} // namespace Stutter
@@ -0,0 +1,129 @@
+#ifndef STUTTER_HPP
+#define STUTTER_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+/**
+ * Per-frame deadline accounting of the render loop.
+ *
+ * A frame is due when the pacer deadline passes, or with vsync no earlier
+ * than one refresh after the previous swap. Its lateness is the time
+ * from the deadline until the swap returned, split into the phases which
+ * consumed it. Consecutive frames which are not on time form a stutter burst.
+ */
+namespace Stutter
+{
+
+using Clock    = std::chrono::steady_clock;
+using Duration = Clock::duration;
+
+enum class FrameClass : std::uint8_t
+{
+    OnTime,
+    Late,   ///< finished after the deadline
+    Dropped ///< finished a whole target interval or more after the deadline
+};
+
+enum class Cause : std::uint8_t
+{
+    None,
+    PacerOversleep, ///< pacer woke up after the deadline
+    DrawSubmit,     ///< clear and draw calls ran past the deadline
+    SwapBlock,      ///< buffer swap blocked
+    EventPolling    ///< event polling of the previous frame ran late
+};
+
+inline constexpr std::size_t causeCount = 5;
+
+/// lateness tolerated before a frame counts as late, ms
+inline constexpr double defaultTolerance = 1.0;
+
+std::string_view toString(FrameClass cls);
+std::string_view toString(Cause cause);
+
+/**
+ * @brief timestamps of one pass through the render loop
+ */
+struct FrameTiming
+{
+    Clock::time_point start;    ///< previous frame finished polling events
+    Clock::time_point drawEnd;  ///< draw calls submitted
+    Clock::time_point deadline; ///< pacer target, after the previous swap
+    Clock::time_point wake;     ///< pacer returned
+    Clock::time_point swapEnd;  ///< swap returned
+    Clock::time_point pollEnd;  ///< events polled
+    Duration interval;          ///< target interval, with vsync >= refresh
+};
+
+struct Burst
+{
+    std::uint64_t firstFrame;
+    std::uint64_t frames;
+    std::uint64_t dropped;
+    Duration start;    ///< deadline of the first frame since the run started
+    Duration duration; ///< until the swap of the last frame returned
+    Cause cause;       ///< phase which contributed most lateness
+};
+
+struct FrameResult
+{
+    FrameClass cls;
+    Cause cause;
+    Duration lateness;
+    std::optional<Burst> endedBurst; ///< burst which this frame ended
+};
+
+class Classifier
+{
+public:
+    explicit Classifier(Duration tolerance);
+
+    /**
+     * @brief classifies a frame and tracks bursts
+     */
+    FrameResult frame(std::uint64_t index, const FrameTiming& timing);
+
+    /**
+     * @brief ends the running burst, call after the last frame
+     */
+    std::optional<Burst> finish();
+
+    [[nodiscard]] std::uint64_t count(FrameClass cls) const
+    {
+        return classCounts.at(static_cast<std::size_t>(cls));
+    }
+
+    [[nodiscard]] std::uint64_t bursts() const { return burstCount; }
+
+    /**
+     * @brief writes frame class counts, lateness per cause and the longest
+     *        bursts
+     */
+    void report(std::ostream& out) const;
+
+private:
+    /// bursts kept for the report, later ones are only counted
+    static constexpr std::size_t maxKeptBursts {4096};
+
+    Duration tolerance;
+    std::optional<Clock::time_point> origin;
+    Duration previousPoll {};
+    std::array<std::uint64_t, 3> classCounts {};
+    std::array<Duration, causeCount> causeLateness {};
+
+    std::optional<Burst> running;
+    std::array<Duration, causeCount> runningLateness {};
+    std::vector<Burst> finished;
+    std::uint64_t burstCount {0};
+};
+
+} // namespace Stutter
+
+#endif // STUTTER_HPP
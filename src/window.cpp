@@ -1,21 +1,46 @@
 #include "window.hpp"
+#include "alloctrack.hpp"
 #include "glmisc.hpp"
 #include "misc.hpp"
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <format>
+#include <fstream>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <ios>
 #include <iostream>
+#include <iterator>
+#include <memory_resource>
 #include <numbers>
 #include <print>
 #include <source_location>
+#include <span>
+#include <sstream>
 #include <stdexcept>
+#include <string_view>
 #include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+Window::Window(Options options)
+    : options(std::move(options)), strip(this->options.shaderDir),
+      renderScale(std::clamp(this->options.renderScale, RenderTarget::minScale,
+                             RenderTarget::maxScale)),
+      stutter(std::chrono::duration_cast<Stutter::Duration>(
+          std::chrono::duration<double, std::milli>(
+              this->options.lateTolerance)))
+{
+}
 
 Window::~Window()
 {
+    shaderReloader.reset();
+    renderTarget.reset();
     if (window != nullptr)
     {
         glfwSetWindowShouldClose(window, GL_TRUE);
@@ -25,55 +50,469 @@ Window::~Window()
 
 void Window::init()
 {
+    auto stageStart = std::chrono::steady_clock::now();
+    auto endStage   = [this, &stageStart](std::string_view stage)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        startupStages.emplace_back(stage, now - stageStart);
+        stageStart = now;
+    };
+
     if (glfwInit() == 0)
     {
         throw std::runtime_error(std::format("{:short}: cannot initialize glfw",
                                              std::source_location::current()));
     }
+    endStage("glfwInit");
+
     createWindow(win_width, win_height, "vrr-test", nullptr,
                  nullptr);
+    if (const auto* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+        mode != nullptr && mode->refreshRate > 0)
+    {
+        refreshInterval = std::chrono::duration_cast<Stutter::Duration>(
+            std::chrono::duration<double>(1.0 / mode->refreshRate));
+    }
+    endStage("window creation");
+
     initGL();
 
     glfwSetFramebufferSizeCallback(window, onFramebufferSize);
     glfwGetFramebufferSize(window, &frameBufferSize.x, &frameBufferSize.y);
-    glViewport(0, 0, frameBufferSize.x, frameBufferSize.y);
 
     glfwSwapInterval(vsync);
+    endStage("glewInit");
+
+    renderTarget.emplace(options.msaaSamples);
+    renderTarget->resize(renderBaseSize(), renderScale);
+    endStage("render target");
+
+    strip.init();
+    if (!options.shaderDir.empty())
+    {
+        shaderReloader.emplace(window, options.shaderDir,
+                               [this]() { return strip.buildShader(); });
+    }
+    endStage("shader build");
+
+    initTelemetry();
+    endStage("telemetry setup");
+
+    drawFrame(0.0F);
+    glfwSwapBuffers(window);
+    glFinish();
+    GLMisc::checkGLerror();
+    endStage("first swap");
+
+    warmUp();
+    endStage("warm-up");
+
+    std::ostringstream report;
+    reportStartup(report);
+    std::print("{}", report.str());
+    std::cout.flush();
 }
 
-void Window::exec()
+void Window::initTelemetry()
 {
-    lastFrameTime = std::chrono::steady_clock::now();
-    while (glfwWindowShouldClose(window) == 0)
+    if (!options.replayPath.empty())
     {
-        update_fps_counter(get_frametime());
-        const auto waitUntil = lastFrameTime
-                             + std::chrono::microseconds(static_cast<unsigned>(
-                                 1'000'000.0 / fpsLimit));
+        replay.emplace(options.replayPath);
+        if (!options.diffPath.empty())
+        {
+            replay->diff.open(options.diffPath, std::ios::trunc);
+            if (!replay->diff)
+            {
+                throw std::runtime_error(
+                    std::format("{:short}: cannot create {}",
+                                std::source_location::current(),
+                                options.diffPath));
+            }
+            replay->diff << "frame,ref_pos,pos,pos_diff,ref_interval_us,"
+                            "interval_us,ref_frametime_ms,frametime_ms,"
+                            "frametime_diff_ms\n";
+        }
+    }
+    if (!options.recordPath.empty())
+    {
+        recorder.emplace(options.recordPath);
+    }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    snapshot.pid = getpid();
+    if (!options.metricsName.empty())
+    {
+        try
+        {
+            metrics.emplace(options.metricsName);
+        }
+        catch (const std::runtime_error& err)
+        {
+            std::println("metrics export disabled: {}", err.what());
+            std::cout.flush();
+        }
+    }
+}
 
-        glClear(GL_COLOR_BUFFER_BIT);
+void Window::warmUp()
+{
+    warmingUp = true;
+    for (unsigned i = 0;
+         i < options.warmupFrames && glfwWindowShouldClose(window) == 0; ++i)
+    {
+        drawFrame(0.0F);
+        glfwSwapBuffers(window);
+        GLMisc::checkGLerror();
+        glfwPollEvents();
         GLMisc::checkGLerror();
+    }
+    warmingUp = false;
+}
+
+void Window::drawFrame(float pos)
+{
+    renderTarget->resize(renderBaseSize(), renderScale);
+    renderTarget->bind();
+
+    glClear(GL_COLOR_BUFFER_BIT);
+    GLMisc::checkGLerror();
 
-        strip.draw(calcPos());
+    strip.draw(pos);
+
+    renderTarget->present(frameBufferSize);
+}
+
+glm::ivec2 Window::renderBaseSize() const
+{
+    if (options.renderSize.x > 0 && options.renderSize.y > 0)
+    {
+        return options.renderSize;
+    }
+    return frameBufferSize;
+}
+
+void Window::setRenderScale(float scale)
+{
+    renderScale = std::clamp(scale, RenderTarget::minScale,
+                             RenderTarget::maxScale);
+    renderTarget->resize(renderBaseSize(), renderScale);
+    const auto size = renderTarget->getSize();
+    frameLog("render scale {}, {}x{}", renderScale, size.x, size.y);
+}
+
+void Window::reportStartup(std::ostream& out) const
+{
+    Stutter::Duration total {};
+    const auto size = renderTarget->getSize();
+    out << std::format("render target: {}x{}, scale {}, {} samples\n",
+                       size.x, size.y, renderScale,
+                       renderTarget->getSamples());
+    out << "startup:\n";
+    for (const auto& [stage, duration] : startupStages)
+    {
+        out << std::format(
+            "  {}: {:.3f} ms\n", stage,
+            std::chrono::duration<double, std::milli>(duration).count());
+        total += duration;
+    }
+    out << std::format(
+        "  total: {:.3f} ms, {} warm-up frames discarded\n",
+        std::chrono::duration<double, std::milli>(total).count(),
+        options.warmupFrames);
+}
+
+void Window::exec()
+{
+    lastFrameTime    = std::chrono::steady_clock::now();
+    auto frameStart  = lastFrameTime;
+    auto lastSwapEnd = lastFrameTime;
+    while (glfwWindowShouldClose(window) == 0)
+    {
+        frameArena.reset();
+        const auto allocations = AllocTrack::thisThread().allocations;
+
+        const auto frametime = get_frametime();
+        update_fps_counter(frametime);
+        const auto targetInterval
+            = static_cast<std::uint32_t>(1'000'000.0 / fpsLimit);
+        const auto interval  = std::chrono::microseconds(targetInterval);
+        const auto waitUntil = lastFrameTime + interval;
+
+        auto clock = glfwGetTime();
+        std::pmr::vector<EventLog::KeyRecord> replayKeys(
+            frameArena.resource());
+        if (replay)
+        {
+            auto queueKey = [&replayKeys](const EventLog::KeyRecord& key)
+            { replayKeys.push_back(key); };
+            if (!replay->log.nextFrame(replay->ref, queueKey))
+            {
+                break;
+            }
+            clock = replay->ref.clock;
+        }
+        const auto pos = static_cast<float>(calcPos(clock));
+
+        if (shaderReloader)
+        {
+            if (auto reloaded = shaderReloader->takeReady())
+            {
+                strip.setShader(std::move(reloaded));
+            }
+        }
+
+        drawFrame(pos);
+        const auto drawEnd = std::chrono::steady_clock::now();
 
         std::this_thread::sleep_until(waitUntil);
-        lastFrameTime = waitUntil;
+        const auto wake = std::chrono::steady_clock::now();
 
         glfwSwapBuffers(window);
         GLMisc::checkGLerror();
+        const auto swapEnd = std::chrono::steady_clock::now();
         glfwPollEvents();
         GLMisc::checkGLerror();
+        const auto pollEnd = std::chrono::steady_clock::now();
+
+        // a frame which overran its slot moves the schedule past the slots
+        // it missed instead of rendering them back to back to catch up
+        lastFrameTime = waitUntil;
+        if (interval > std::chrono::microseconds::zero())
+        {
+            const auto missedSlots = std::max<Stutter::Duration::rep>(
+                0, (swapEnd - waitUntil) / interval);
+            lastFrameTime += missedSlots * interval;
+        }
+
+        // with vsync the swap cannot return before the refresh after the
+        // previous swap, a pacer target above the refresh rate is no deadline
+        auto deadline      = waitUntil;
+        auto frameInterval = Stutter::Duration(interval);
+        if (vsync != 0)
+        {
+            deadline      = std::max(waitUntil, lastSwapEnd + refreshInterval);
+            frameInterval = std::max(frameInterval, refreshInterval);
+        }
+        lastSwapEnd = swapEnd;
+
+        const auto cls = accountDeadline({.start    = frameStart,
+                                          .drawEnd  = drawEnd,
+                                          .deadline = deadline,
+                                          .wake     = wake,
+                                          .swapEnd  = swapEnd,
+                                          .pollEnd  = pollEnd,
+                                          .interval = frameInterval});
+        frameStart = pollEnd;
+
+        const EventLog::FrameRecord rec {
+            .frame          = frameIndex,
+            .clock          = clock,
+            .interval       = frametime,
+            .targetInterval = targetInterval,
+            .pos            = pos,
+            .cls            = static_cast<std::uint8_t>(cls)};
+        if (recorder)
+        {
+            recorder->write(rec);
+        }
+        if (replay)
+        {
+            replayFrame(rec, replayKeys);
+        }
+        ++frameIndex;
+
+        ++snapshot.frameCount;
+        publishMetrics();
+        accountAllocations(allocations);
+    }
+
+    if (const auto burst = stutter.finish())
+    {
+        onBurst(*burst);
+    }
+    if (replay)
+    {
+        printReplaySummary();
+    }
+    writeReport();
+    if (recorder)
+    {
+        recorder->close();
     }
 }
 
+Stutter::FrameClass Window::accountDeadline(const Stutter::FrameTiming& timing)
+{
+    const auto result = stutter.frame(frameIndex, timing);
+    if (result.cls != Stutter::FrameClass::OnTime)
+    {
+        ++snapshot.missedDeadlines;
+    }
+    if (result.cls == Stutter::FrameClass::Dropped)
+    {
+        ++snapshot.droppedFrames;
+    }
+    if (result.endedBurst)
+    {
+        onBurst(*result.endedBurst);
+    }
+    return result.cls;
+}
+
+void Window::accountAllocations(std::uint64_t before)
+{
+    if constexpr (AllocTrack::enabled)
+    {
+        const auto count = AllocTrack::thisThread().allocations - before;
+        if (count == 0)
+        {
+            return;
+        }
+        ++allocatingFrames;
+        maxFrameAllocations = std::max(maxFrameAllocations, count);
+        if (options.assertNoAlloc)
+        {
+            throw std::runtime_error(
+                std::format("{:short}: {} heap allocations in frame {}",
+                            std::source_location::current(), count,
+                            frameIndex - 1));
+        }
+    }
+}
+
+void Window::reportAllocations(std::ostream& out) const
+{
+    if constexpr (!AllocTrack::enabled)
+    {
+        out << "allocations: not tracked, build with "
+               "VRR_TEST_ALLOC_TRACKING\n";
+    }
+    else
+    {
+        auto unnamed = AllocTrack::process();
+        out << std::format("allocations: {} frames allocated, at most {} "
+                           "per frame\n",
+                           allocatingFrames, maxFrameAllocations);
+        for (const auto& [name, counters] : AllocTrack::namedThreads())
+        {
+            out << std::format("  {}: {} allocations, {} bytes\n", name,
+                               counters.allocations, counters.bytes);
+            unnamed.allocations -= counters.allocations;
+            unnamed.bytes       -= counters.bytes;
+        }
+        out << std::format("  unnamed threads: {} allocations, {} bytes\n",
+                           unnamed.allocations, unnamed.bytes);
+    }
+}
+
+void Window::onBurst(const Stutter::Burst& burst)
+{
+    const auto start    = std::chrono::duration<double>(burst.start).count();
+    const auto duration = std::chrono::duration<double>(burst.duration).count();
+
+    frameLog("stutter: frame {}, {} frames, {} dropped, {:.3f} ms, {}",
+             burst.firstFrame, burst.frames, burst.dropped, duration * 1000.0,
+             Stutter::toString(burst.cause));
+
+    if (recorder)
+    {
+        recorder->write(EventLog::BurstRecord {
+            .firstFrame = burst.firstFrame,
+            .frames     = burst.frames,
+            .dropped    = burst.dropped,
+            .start      = start,
+            .duration   = duration,
+            .cause      = static_cast<std::uint8_t>(burst.cause)});
+    }
+
+    ++snapshot.stutterBursts;
+    snapshot.lastBurstDuration = duration * 1000.0;
+    snapshot.lastBurstCause    = static_cast<std::int64_t>(burst.cause);
+}
+
+void Window::writeReport() const
+{
+    std::ostringstream report;
+    reportStartup(report);
+    stutter.report(report);
+    reportAllocations(report);
+
+    std::print("{}", report.str());
+    std::cout.flush();
+
+    if (!options.reportPath.empty())
+    {
+        std::ofstream file(options.reportPath, std::ios::trunc);
+        file << report.str();
+        if (!file)
+        {
+            throw std::runtime_error(
+                std::format("{:short}: cannot write {}",
+                            std::source_location::current(),
+                            options.reportPath));
+        }
+    }
+}
+
+void Window::replayFrame(const EventLog::FrameRecord& rec,
+                         std::span<const EventLog::KeyRecord> keys)
+{
+    // keys were delivered while polling events of this frame in the
+    // recorded run, apply them at the same point
+    for (const auto& key : keys)
+    {
+        handleKey(key.key, key.action, key.mods);
+    }
+
+    const auto& ref          = replay->ref;
+    const auto posDiff       = static_cast<double>(rec.pos) - ref.pos;
+    const auto frameTimeDiff = (rec.interval - ref.interval) * 1000.0;
+
+    ++replay->frames;
+    if (rec.pos != ref.pos)
+    {
+        ++replay->posMismatches;
+        replay->maxPosDiff = std::max(replay->maxPosDiff, std::abs(posDiff));
+    }
+    if (rec.targetInterval != ref.targetInterval)
+    {
+        ++replay->intervalMismatches;
+    }
+    replay->frameTimeDiffSum += frameTimeDiff;
+
+    if (replay->diff.is_open())
+    {
+        std::format_to(std::ostreambuf_iterator<char>(replay->diff),
+                       "{},{},{},{},{},{},{:.6f},{:.6f},{:.6f}\n", rec.frame,
+                       ref.pos, rec.pos, posDiff, ref.targetInterval,
+                       rec.targetInterval, ref.interval * 1000.0,
+                       rec.interval * 1000.0, frameTimeDiff);
+    }
+}
+
+void Window::printReplaySummary() const
+{
+    std::println("replay: {} frames, {} position mismatches (max {}), "
+                 "{} target interval mismatches",
+                 replay->frames, replay->posMismatches, replay->maxPosDiff,
+                 replay->intervalMismatches);
+    if (replay->frames != 0)
+    {
+        std::println("replay: mean frame time delta {:+.3f} ms",
+                     replay->frameTimeDiffSum
+                         / static_cast<double>(replay->frames));
+    }
+    std::cout.flush();
+}
+
 void Window::createWindow(int width, int height, const char *title, GLFWmonitor *monitor, GLFWwindow *share)
 {
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
     glfwWindowHint(GLFW_SCALE_TO_MONITOR, GL_TRUE);
+    // multisampling happens in the render target, the blit into a
+    // multisampled default framebuffer would fail
+    glfwWindowHint(GLFW_SAMPLES, 0);
 #ifndef NDEBUG
     glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
 #endif
@@ -103,9 +542,29 @@ void Window::createWindow(int width, int height, const char *title, GLFWmonitor
 }
 
 void Window::onkeyboard(GLFWwindow* window, int key,
-                        [[maybe_unused]] int scancode, int action,
-                        [[maybe_unused]] int mods)
+                        [[maybe_unused]] int scancode, int action, int mods)
 {
+    if (replay || warmingUp)
+    {
+        // replayed runs are driven by the log and warm-up frames are not
+        // part of the run, live input may only quit
+        if ((key == GLFW_KEY_ESCAPE || key == GLFW_KEY_Q)
+            && action == GLFW_PRESS)
+        {
+            glfwSetWindowShouldClose(window, GL_TRUE);
+        }
+        return;
+    }
+    handleKey(key, action, mods);
+}
+
+void Window::handleKey(int key, int action, int mods)
+{
+    if (recorder)
+    {
+        recorder->write(EventLog::KeyRecord {frameIndex, key, action, mods});
+    }
+
     if ((key == GLFW_KEY_ESCAPE || key == GLFW_KEY_Q) && action == GLFW_PRESS)
     {
         glfwSetWindowShouldClose(window, GL_TRUE);
@@ -115,47 +574,49 @@ void Window::onkeyboard(GLFWwindow* window, int key,
     {
         vsync = (vsync == 0) ? 1 : 0;
         glfwSwapInterval(vsync);
-        std::println("swap interval {}", vsync);
-        std::cout.flush();
+        frameLog("swap interval {}", vsync);
     }
 
     if (key == GLFW_KEY_W && action == GLFW_PRESS)
     {
         speed *= speedStep;
-        std::println("speed {}", speed);
-        std::cout.flush();
+        frameLog("speed {}", speed);
     }
     if (key == GLFW_KEY_S && action == GLFW_PRESS)
     {
         speed /= speedStep;
-        std::println("speed {}", speed);
-        std::cout.flush();
+        frameLog("speed {}", speed);
     }
 
     if (key == GLFW_KEY_E && action == GLFW_PRESS)
     {
         fpsLimit += 10;
-        std::println("fps limit {}", fpsLimit);
-        std::cout.flush();
+        frameLog("fps limit {}", fpsLimit);
     }
     if (key == GLFW_KEY_D && action == GLFW_PRESS)
     {
-        fpsLimit -= 10;
-        std::println("fps limit {}", fpsLimit);
-        std::cout.flush();
+        fpsLimit = fpsLimit > minFpsLimit + 10 ? fpsLimit - 10 : minFpsLimit;
+        frameLog("fps limit {}", fpsLimit);
     }
 
     if (key == GLFW_KEY_R && action == GLFW_PRESS)
     {
         fpsLimit += 1;
-        std::println("fps limit {}", fpsLimit);
-        std::cout.flush();
+        frameLog("fps limit {}", fpsLimit);
     }
     if (key == GLFW_KEY_F && action == GLFW_PRESS)
     {
-        fpsLimit -= 1;
-        std::println("fps limit {}", fpsLimit);
-        std::cout.flush();
+        fpsLimit = fpsLimit > minFpsLimit ? fpsLimit - 1 : minFpsLimit;
+        frameLog("fps limit {}", fpsLimit);
+    }
+
+    if (key == GLFW_KEY_Z && action == GLFW_PRESS)
+    {
+        setRenderScale(renderScale - renderScaleStep);
+    }
+    if (key == GLFW_KEY_X && action == GLFW_PRESS)
+    {
+        setRenderScale(renderScale + renderScaleStep);
     }
 }
 
@@ -256,33 +717,49 @@ void Window::onFramebufferSize(GLFWwindow* window, int width, int height)
     auto* w = static_cast<Window*>(glfwGetWindowUserPointer(window));
     w->frameBufferSize.x = width;
     w->frameBufferSize.y = height;
-    glViewport(0, 0, width, height);
 }
 
-double Window::calcPos() const
+double Window::calcPos(double time)
 {
-    static auto lastTime  = glfwGetTime();
-    static double phase   = 0.0;
-    const auto time = glfwGetTime();
-    phase                += 2 * std::numbers::pi * speed * (time - lastTime);
-    lastTime              = time;
+    if (!lastPosTime)
+    {
+        lastPosTime = time;
+    }
+    phase       += 2 * std::numbers::pi * speed * (time - *lastPosTime);
+    lastPosTime  = time;
     return std::sin(phase);
 }
 
 void Window::update_fps_counter(double frametime)
 {
-    static int frame_count;
-    static double time  = 0;
-    time               += frametime;
-    if (time > 1)
-    {
-        const auto fps = frame_count / time;
-        std::println("fps: {:>6.2f}", fps);
-        std::cout.flush();
-        frame_count = 0;
-        time        = 0;
-    }
-    ++frame_count;
+    fpsTime += frametime;
+    frameTimes.add(frametime * 1000.0);
+    if (fpsTime > 1)
+    {
+        const auto fps = fpsFrameCount / fpsTime;
+        frameLog("fps: {:>6.2f}", fps);
+
+        snapshot.achievedRate = fps;
+        snapshot.p50FrameTime = frameTimes.percentile(0.50);
+        snapshot.p95FrameTime = frameTimes.percentile(0.95);
+        snapshot.p99FrameTime = frameTimes.percentile(0.99);
+
+        fpsFrameCount = 0;
+        fpsTime       = 0;
+        frameTimes.clear();
+    }
+    ++fpsFrameCount;
+}
+
+void Window::publishMetrics()
+{
+    if (!metrics)
+    {
+        return;
+    }
+    snapshot.targetRate   = fpsLimit;
+    snapshot.swapInterval = vsync;
+    metrics->publish(snapshot);
 }
 
 double Window::get_frametime()
@@ -1,16 +1,65 @@
 #ifndef WINDOW_HPP
 #define WINDOW_HPP
 
+#include "eventlog.hpp"
+#include "framearena.hpp"
+#include "histogram.hpp"
+#include "metrics.hpp"
+#include "rendertarget.hpp"
+#include "shaderreloader.hpp"
 #include "strip.hpp"
+#include "stutter.hpp"
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <fstream>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
+#include <iostream>
+#include <iterator>
+#include <memory_resource>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 class Window
 {
 public:
-    Window() = default;
+    struct Options
+    {
+        /// shared memory segment for live metrics, empty disables export
+        std::string metricsName {Metrics::defaultSegmentName};
+        /// write event log of the run here
+        std::string recordPath;
+        /// re-drive the run from this event log
+        std::string replayPath;
+        /// per-frame replay differences as csv
+        std::string diffPath;
+        /// final report is also written here
+        std::string reportPath;
+        /// frames finishing later than this after the deadline are late, ms
+        double lateTolerance {Stutter::defaultTolerance};
+        /// load shaders from here and reload them on change
+        std::string shaderDir;
+        /// frames rendered and discarded before timing starts
+        unsigned warmupFrames {60};
+        /// fail when the frame loop allocates, needs alloc tracking build
+        bool assertNoAlloc {false};
+        /// render target size relative to the base size
+        float renderScale {1.0F};
+        /// base size of the render target, zero follows the window
+        glm::ivec2 renderSize {0, 0};
+        /// MSAA samples of the render target, 0 disables multisampling
+        int msaaSamples {4};
+    };
+
+    explicit Window(Options options);
     Window(const Window& o) = delete;
     Window(Window&& o) = delete;
     Window* operator=(const Window& o) = delete;
@@ -26,17 +75,50 @@ private:
                       GLFWmonitor *monitor, GLFWwindow *share);
     void onkeyboard(GLFWwindow* window, int key, int scancode, int action,
                     int mods);
+    void handleKey(int key, int action, int mods);
     static void initGL();
+    void initTelemetry();
+    void warmUp();
+    void drawFrame(float pos);
+    void reportStartup(std::ostream& out) const;
     static void onerror(int error, const char *description);
     static void APIENTRY glDebugOutput(GLenum source, GLenum type, GLuint id,
                                        GLenum severity, GLsizei length,
                                        const GLchar *message,
                                        const void *userParam);
     static void onFramebufferSize(GLFWwindow* window, int width, int height);
-    [[nodiscard]] double calcPos() const;
+    [[nodiscard]] glm::ivec2 renderBaseSize() const;
+    void setRenderScale(float scale);
+    double calcPos(double time);
 
-    static void update_fps_counter(double frametime);
+    void update_fps_counter(double frametime);
     static double get_frametime();
+    void publishMetrics();
+    void replayFrame(const EventLog::FrameRecord& rec,
+                     std::span<const EventLog::KeyRecord> keys);
+    void printReplaySummary() const;
+    Stutter::FrameClass accountDeadline(const Stutter::FrameTiming& timing);
+    void onBurst(const Stutter::Burst& burst);
+    void writeReport() const;
+    void accountAllocations(std::uint64_t before);
+    void reportAllocations(std::ostream& out) const;
+
+    /**
+     * @brief prints a line from the frame loop
+     * @note formats into the frame arena, std::println would allocate
+     */
+    template<typename... Args>
+    void frameLog(std::format_string<Args...> fmt, Args&&... args)
+    {
+        std::pmr::string line(frameArena.resource());
+        std::format_to(std::back_inserter(line), fmt,
+                       std::forward<Args>(args)...);
+        line.push_back('\n');
+        std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+        std::cout.flush();
+    }
+
+    Options options;
 
     int win_width        = 1600;
     int win_height       = 900;
@@ -45,12 +127,54 @@ private:
     glm::ivec2 frameBufferSize{0, 0};
 
     Strip strip;
+    std::optional<RenderTarget> renderTarget;
+    static constexpr float renderScaleStep {0.25F};
+    float renderScale;
 
     static constexpr float speedStep {1.3F};
     float speed {0.1F};
     int vsync         = 1;
+    static constexpr unsigned minFpsLimit {1};
     unsigned fpsLimit = 200;
     std::chrono::time_point<std::chrono::steady_clock> lastFrameTime;
+    std::optional<double> lastPosTime;
+    /// refresh period of the primary monitor, zero if unknown
+    Stutter::Duration refreshInterval {};
+    double phase {0.0};
+    std::uint64_t frameIndex {0};
+
+    std::vector<std::pair<std::string_view, Stutter::Duration>> startupStages;
+    bool warmingUp {false};
+
+    static constexpr std::size_t frameArenaSize {64UL * 1024};
+    FrameArena frameArena {frameArenaSize};
+    std::uint64_t allocatingFrames {0};
+    std::uint64_t maxFrameAllocations {0};
+    Stutter::Classifier stutter;
+    std::optional<Metrics::Publisher> metrics;
+    Metrics::Snapshot snapshot {};
+
+    Histogram frameTimes;
+    int fpsFrameCount {0};
+    double fpsTime {0.0};
+
+    struct Replay
+    {
+        explicit Replay(const std::string& path) : log(path) {}
+
+        EventLog::Reader log;
+        EventLog::FrameRecord ref {};
+        std::ofstream diff;
+        std::uint64_t frames {0};
+        std::uint64_t posMismatches {0};
+        std::uint64_t intervalMismatches {0};
+        double maxPosDiff {0.0};
+        double frameTimeDiffSum {0.0};
+    };
+
+    std::optional<EventLog::Writer> recorder;
+    std::optional<Replay> replay;
+    std::optional<ShaderReloader> shaderReloader;
 };
 
 #endif // WINDOW_HPP